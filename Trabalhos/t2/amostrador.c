@@ -0,0 +1,285 @@
+#include "amostrador.h"
+#include "tabsimb.h"
+#include "instrucao.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// tamanho do vetor de amostras
+#define AMO_N_AMOSTRAS 16384
+// maior número de quadros de uma pilha (o PC e as chamadas)
+#define AMO_PROFUNDIDADE 16
+
+typedef enum { AMO_USUARIO, AMO_SO, AMO_OCIOSO } amo_tipo_t;
+
+// uma amostra: o processo e os endereços da pilha (quadros[0] é o PC, os
+//   outros são os endereços das instruções CHAMA que levaram até ele)
+// depois de agrupadas, os quadros são números de rótulos (ver
+//   amo_simboliza), e 'n_amostras' é quantas são iguais
+typedef struct {
+  amo_tipo_t tipo;
+  int prog;            // índice do programa, -1 se não for AMO_USUARIO
+  int pid;
+  int n_quadros;
+  int quadros[AMO_PROFUNDIDADE + 1];
+  long n_amostras;
+} amostra_t;
+
+// um programa executado, com sua tabela de símbolos
+typedef struct {
+  char *nome;
+  tabsimb_t *tab;
+} prog_t;
+
+struct amostrador_t {
+  cpu_t *cpu;
+  mmu_t *mmu;
+  int periodo;
+  long proxima;
+  // processo em execução (prog é -1 se nenhum)
+  int pid;
+  int prog;
+  prog_t *progs;
+  int n_progs;
+  // amostras ainda não agrupadas
+  amostra_t *amostras;
+  int n_amostras;
+  // pilhas agrupadas, em ordem (ver compara_pilha)
+  amostra_t *pilhas;
+  int n_pilhas;
+  long n_perdidas;     // amostras que não puderam ser agrupadas
+};
+
+amostrador_t *amo_cria(cpu_t *cpu, mmu_t *mmu, int periodo)
+{
+  amostrador_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->amostras = malloc(AMO_N_AMOSTRAS * sizeof(amostra_t));
+  if (self->amostras == NULL) {
+    free(self);
+    return NULL;
+  }
+  self->cpu = cpu;
+  self->mmu = mmu;
+  self->periodo = periodo > 0 ? periodo : 1;
+  self->proxima = self->periodo;
+  self->pid = 0;
+  self->prog = -1;
+  self->progs = NULL;
+  self->n_progs = 0;
+  self->n_amostras = 0;
+  self->pilhas = NULL;
+  self->n_pilhas = 0;
+  self->n_perdidas = 0;
+  return self;
+}
+
+void amo_destroi(amostrador_t *self)
+{
+  for (int i = 0; i < self->n_progs; i++) {
+    free(self->progs[i].nome);
+    if (self->progs[i].tab != NULL) tabsimb_destroi(self->progs[i].tab);
+  }
+  free(self->progs);
+  free(self->amostras);
+  free(self->pilhas);
+  free(self);
+}
+
+void amo_define_processo(amostrador_t *self, int pid, char *programa)
+{
+  self->pid = pid;
+  self->prog = -1;
+  if (programa == NULL) return;
+  for (int i = 0; i < self->n_progs; i++) {
+    if (strcmp(self->progs[i].nome, programa) == 0) {
+      self->prog = i;
+      return;
+    }
+  }
+  prog_t *progs = realloc(self->progs, (self->n_progs + 1) * sizeof(prog_t));
+  if (progs == NULL) return;
+  self->progs = progs;
+  char *nome = strdup(programa);
+  if (nome == NULL) return;
+  // a tabela é lida uma vez por programa; sem ela, a pilha fica só com o PC
+  self->progs[self->n_progs] = (prog_t){ nome, tabsimb_le(programa) };
+  self->prog = self->n_progs++;
+}
+
+long amo_proxima(amostrador_t *self)
+{
+  return self->proxima;
+}
+
+
+// amostragem
+
+// completa a pilha da amostra, a partir do PC em quadros[0]
+// enquanto o endereço está em uma subrotina, o endereço de retorno
+//   guardado no rótulo dela menos 2 é o da CHAMA que a chamou; para se a
+//   memória não puder ser lida, se lá não tiver uma CHAMA (a subrotina
+//   pode ter sido alcançada por desvio) ou se a subrotina já está na pilha
+//   (em uma recursão, o endereço de retorno foi sobrescrito)
+static void amo_percorre_pilha(amostrador_t *self, amostra_t *a,
+                               tabsimb_t *tab)
+{
+  int subrotinas[AMO_PROFUNDIDADE];
+  int n_subrotinas = 0;
+  int pc = a->quadros[0];
+  while (a->n_quadros < AMO_PROFUNDIDADE) {
+    int sub = tabsimb_busca_subrotina(tab, pc);
+    if (sub == -1) break;
+    for (int i = 0; i < n_subrotinas; i++) {
+      if (subrotinas[i] == sub) return;
+    }
+    subrotinas[n_subrotinas++] = sub;
+    int end, ret, opcode;
+    tabsimb_rotulo(tab, sub, &end);
+    if (mmu_consulta(self->mmu, end, &ret) != ERR_OK) break;
+    pc = ret - 2;
+    if (mmu_consulta(self->mmu, pc, &opcode) != ERR_OK || opcode != CHAMA) {
+      break;
+    }
+    a->quadros[a->n_quadros++] = pc;
+  }
+}
+
+static void amo_agrupa(amostrador_t *self);
+
+void amo_amostra(amostrador_t *self, long agora)
+{
+  self->proxima = agora + self->periodo;
+  if (self->n_amostras == AMO_N_AMOSTRAS) amo_agrupa(self);
+  amostra_t *a = &self->amostras[self->n_amostras++];
+  a->prog = -1;
+  a->pid = 0;
+  a->n_quadros = 0;
+  a->n_amostras = 1;
+  // a CPU parada, esperando interrupção, pode estar em qualquer modo (fica
+  //   em supervisor quando o SO termina)
+  if (cpu_erro(self->cpu) == ERR_CPU_PARADA) {
+    a->tipo = AMO_OCIOSO;
+  } else if (cpu_modo(self->cpu) == supervisor) {
+    a->tipo = AMO_SO;
+  } else if (self->prog == -1) {
+    a->tipo = AMO_OCIOSO;
+  } else {
+    a->tipo = AMO_USUARIO;
+    a->prog = self->prog;
+    a->pid = self->pid;
+    a->quadros[a->n_quadros++] = cpu_pc(self->cpu);
+    tabsimb_t *tab = self->progs[a->prog].tab;
+    if (tab != NULL) amo_percorre_pilha(self, a, tab);
+  }
+}
+
+
+// agrupamento
+
+static int compara_pilha(const amostra_t *a, const amostra_t *b)
+{
+  if (a->tipo != b->tipo) return a->tipo - b->tipo;
+  if (a->prog != b->prog) return a->prog - b->prog;
+  if (a->pid != b->pid) return a->pid - b->pid;
+  if (a->n_quadros != b->n_quadros) return a->n_quadros - b->n_quadros;
+  for (int i = 0; i < a->n_quadros; i++) {
+    if (a->quadros[i] != b->quadros[i]) return a->quadros[i] - b->quadros[i];
+  }
+  return 0;
+}
+
+// soma a pilha às agrupadas, mantendo a ordem
+static void amo_insere_pilha(amostrador_t *self, amostra_t *pilha)
+{
+  int ini = 0, fim = self->n_pilhas - 1;
+  while (ini <= fim) {
+    int meio = (ini + fim) / 2;
+    int c = compara_pilha(pilha, &self->pilhas[meio]);
+    if (c == 0) {
+      self->pilhas[meio].n_amostras += pilha->n_amostras;
+      return;
+    }
+    if (c < 0) {
+      fim = meio - 1;
+    } else {
+      ini = meio + 1;
+    }
+  }
+  amostra_t *pilhas = realloc(self->pilhas,
+                              (self->n_pilhas + 1) * sizeof(amostra_t));
+  if (pilhas == NULL) {
+    self->n_perdidas += pilha->n_amostras;
+    return;
+  }
+  self->pilhas = pilhas;
+  memmove(&pilhas[ini + 1], &pilhas[ini],
+          (self->n_pilhas - ini) * sizeof(amostra_t));
+  pilhas[ini] = *pilha;
+  self->n_pilhas++;
+}
+
+// troca os endereços da amostra pelos rótulos das funções em que estão (a
+//   subrotina, ou o rótulo anterior, fora delas; -1 se nenhum)
+// se o PC está em um rótulo dentro da subrotina (um laço, por exemplo), ele
+//   é acrescentado como mais um quadro
+static void amo_simboliza(amostra_t *a, tabsimb_t *tab)
+{
+  if (tab == NULL) {
+    for (int q = 0; q < a->n_quadros; q++) a->quadros[q] = -1;
+    return;
+  }
+  int rotulo = tabsimb_busca_rotulo(tab, a->quadros[0]);
+  for (int q = 0; q < a->n_quadros; q++) {
+    int sub = tabsimb_busca_subrotina(tab, a->quadros[q]);
+    a->quadros[q] = sub != -1 ? sub : tabsimb_busca_rotulo(tab, a->quadros[q]);
+  }
+  if (rotulo != a->quadros[0]) {
+    memmove(&a->quadros[1], &a->quadros[0], a->n_quadros * sizeof(int));
+    a->quadros[0] = rotulo;
+    a->n_quadros++;
+  }
+}
+
+// agrupa as amostras em pilhas de rótulos, e esvazia o vetor de amostras
+static void amo_agrupa(amostrador_t *self)
+{
+  for (int i = 0; i < self->n_amostras; i++) {
+    amostra_t *a = &self->amostras[i];
+    if (a->tipo == AMO_USUARIO) {
+      amo_simboliza(a, self->progs[a->prog].tab);
+    }
+    amo_insere_pilha(self, a);
+  }
+  self->n_amostras = 0;
+}
+
+bool amo_grava(amostrador_t *self, char *nome)
+{
+  amo_agrupa(self);
+  FILE *arq = fopen(nome, "w");
+  if (arq == NULL) return false;
+  for (int i = 0; i < self->n_pilhas; i++) {
+    amostra_t *p = &self->pilhas[i];
+    if (p->tipo == AMO_SO) {
+      fprintf(arq, "SO");
+    } else if (p->tipo == AMO_OCIOSO) {
+      fprintf(arq, "ocioso");
+    } else {
+      prog_t *prog = &self->progs[p->prog];
+      fprintf(arq, "%s;pid %d", prog->nome, p->pid);
+      // do mais externo para o PC
+      for (int q = p->n_quadros - 1; q >= 0; q--) {
+        int end;
+        fprintf(arq, ";%s", p->quadros[q] == -1 ? "?"
+                            : tabsimb_rotulo(prog->tab, p->quadros[q], &end));
+      }
+    }
+    fprintf(arq, " %ld\n", p->n_amostras);
+  }
+  if (self->n_perdidas > 0) {
+    fprintf(arq, "(perdidas) %ld\n", self->n_perdidas);
+  }
+  return fclose(arq) == 0;
+}
@@ -0,0 +1,51 @@
+#ifndef AMOSTRADOR_H
+#define AMOSTRADOR_H
+
+// amostrador
+// perfil estatístico da execução: a cada período do relógio simulado,
+//   registra o que a CPU está executando (processo, PC e modo), com a
+//   cadeia de chamadas do programa
+// as amostras ficam em um vetor alocado na criação; quando enche, elas
+//   são agrupadas em pilhas iguais, e o vetor é reusado
+// no final, grava as pilhas no formato "colapsado" do flamegraph, uma por
+//   linha, com os quadros separados por ';' e o número de amostras:
+//     p1.maq;pid 2;main;principal;laco 37
+//   o primeiro quadro é o programa, ou "SO" para o código executado em
+//   modo supervisor, ou "ocioso" quando a CPU está parada esperando
+//   interrupção
+// a cadeia de chamadas é reconstruída pela convenção da instrução CHAMA,
+//   que guarda o endereço de retorno no rótulo da subrotina (ver
+//   tabsimb.h): se o PC está em uma subrotina, quem chamou está no
+//   endereço guardado no início dela, menos 2
+// o amostrador não é chamado a cada instrução: o controle termina o lote
+//   de instruções no momento da próxima amostra (ver amo_proxima)
+
+#include <stdbool.h>
+#include "cpu.h"
+#include "mmu.h"
+
+typedef struct amostrador_t amostrador_t;
+
+// cria um amostrador, que amostra a CPU 'cpu' (e a memória do processo,
+//   pela MMU 'mmu') a cada 'periodo' unidades de tempo
+// retorna NULL em caso de erro
+amostrador_t *amo_cria(cpu_t *cpu, mmu_t *mmu, int periodo);
+
+// destrói o amostrador
+void amo_destroi(amostrador_t *self);
+
+// define o processo que a CPU executa em modo usuário: o 'pid' e o nome
+//   do arquivo executável 'programa' (NULL se nenhum)
+void amo_define_processo(amostrador_t *self, int pid, char *programa);
+
+// retorna o momento da próxima amostra
+long amo_proxima(amostrador_t *self);
+
+// registra uma amostra do estado da CPU no momento 'agora'
+void amo_amostra(amostrador_t *self, long agora);
+
+// grava as pilhas colapsadas no arquivo 'nome'
+// retorna false em caso de erro
+bool amo_grava(amostrador_t *self, char *nome);
+
+#endif // AMOSTRADOR_H
@@ -0,0 +1,135 @@
+#include "cacheprog.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// uma entrada do cache
+typedef struct {
+  char *nome;            // nome do arquivo, NULL se a entrada está livre
+  // o arquivo lido (ver prog_arquivo)
+  dev_t disp;
+  ino_t inode;
+  struct timespec data;  // data de alteração
+  off_t tam;             // tamanho
+  programa_t *prog;
+  long uso;              // quando foi usado pela última vez
+} entrada_t;
+
+struct cacheprog_t {
+  int capacidade;
+  entrada_t *entradas;
+  long relogio;          // contador de usos, para o LRU
+  int acertos;
+  int faltas;
+};
+
+cacheprog_t *cacheprog_cria(int capacidade)
+{
+  if (capacidade < 1) return NULL;
+  cacheprog_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->entradas = calloc(capacidade, sizeof(entrada_t));
+  if (self->entradas == NULL) {
+    free(self);
+    return NULL;
+  }
+  self->capacidade = capacidade;
+  self->relogio = 0;
+  self->acertos = 0;
+  self->faltas = 0;
+  return self;
+}
+
+static void esvazia_entrada(entrada_t *entrada)
+{
+  if (entrada->nome == NULL) return;
+  free(entrada->nome);
+  prog_destroi(entrada->prog);
+  entrada->nome = NULL;
+  entrada->prog = NULL;
+}
+
+void cacheprog_destroi(cacheprog_t *self)
+{
+  for (int i = 0; i < self->capacidade; i++) {
+    esvazia_entrada(&self->entradas[i]);
+  }
+  free(self->entradas);
+  free(self);
+}
+
+// retorna a entrada com o nome, ou NULL
+static entrada_t *busca(cacheprog_t *self, char *nome)
+{
+  for (int i = 0; i < self->capacidade; i++) {
+    entrada_t *entrada = &self->entradas[i];
+    if (entrada->nome != NULL && strcmp(entrada->nome, nome) == 0) {
+      return entrada;
+    }
+  }
+  return NULL;
+}
+
+// retorna uma entrada livre, ou a usada há mais tempo
+static entrada_t *escolhe_vitima(cacheprog_t *self)
+{
+  entrada_t *vitima = &self->entradas[0];
+  for (int i = 0; i < self->capacidade; i++) {
+    entrada_t *entrada = &self->entradas[i];
+    if (entrada->nome == NULL) return entrada;
+    if (entrada->uso < vitima->uso) vitima = entrada;
+  }
+  return vitima;
+}
+
+programa_t *cacheprog_pega(cacheprog_t *self, char *nome)
+{
+  // a validade é verificada no arquivo que prog_cria lê (o '.mqb' mapeado,
+  //   em geral), não no que foi pedido
+  char arquivo[strlen(nome) + 1];
+  struct stat st;
+  if (!prog_arquivo(nome, sizeof(arquivo), arquivo)
+      || stat(arquivo, &st) == -1) {
+    return NULL;
+  }
+  entrada_t *entrada = busca(self, nome);
+  if (entrada != NULL) {
+    if (entrada->disp == st.st_dev && entrada->inode == st.st_ino
+        && entrada->tam == st.st_size
+        && entrada->data.tv_sec == st.st_mtim.tv_sec
+        && entrada->data.tv_nsec == st.st_mtim.tv_nsec) {
+      self->acertos++;
+      entrada->uso = ++self->relogio;
+      return entrada->prog;
+    }
+    // o arquivo foi alterado, a cópia no cache não serve mais
+    esvazia_entrada(entrada);
+  }
+  self->faltas++;
+  programa_t *prog = prog_cria(nome);
+  if (prog == NULL) return NULL;
+  entrada = escolhe_vitima(self);
+  esvazia_entrada(entrada);
+  entrada->nome = strdup(nome);
+  if (entrada->nome == NULL) {
+    prog_destroi(prog);
+    return NULL;
+  }
+  entrada->disp = st.st_dev;
+  entrada->inode = st.st_ino;
+  entrada->data = st.st_mtim;
+  entrada->tam = st.st_size;
+  entrada->prog = prog;
+  entrada->uso = ++self->relogio;
+  return prog;
+}
+
+int cacheprog_acertos(cacheprog_t *self)
+{
+  return self->acertos;
+}
+
+int cacheprog_faltas(cacheprog_t *self)
+{
+  return self->faltas;
+}
@@ -0,0 +1,40 @@
+#ifndef CACHEPROG_H
+#define CACHEPROG_H
+
+// cache de programas
+// mantém os programas lidos mais recentemente, para que a criação de
+//   processos que executam o mesmo programa não precise ler e interpretar
+//   o arquivo novamente
+// cada programa é identificado pelo nome do arquivo e pelo arquivo que é
+//   realmente lido para ele (o '.mqb' correspondente, se estiver
+//   atualizado, ver prog_arquivo), com a sua data de alteração e tamanho;
+//   se esse arquivo mudar ou for alterado, o programa é lido de novo
+// o número de programas mantidos é limitado; quando o cache está cheio,
+//   o programa usado há mais tempo é removido (LRU)
+
+#include "programa.h"
+
+typedef struct cacheprog_t cacheprog_t;
+
+// cria um cache com capacidade para 'capacidade' programas
+// retorna NULL em caso de erro
+cacheprog_t *cacheprog_cria(int capacidade);
+
+// destrói o cache e todos os programas que ele contém
+void cacheprog_destroi(cacheprog_t *self);
+
+// retorna o programa contido no arquivo 'nome'
+// se o programa estiver no cache e o arquivo não tiver sido alterado,
+//   retorna o programa do cache; senão, lê o arquivo (com prog_cria) e
+//   coloca o programa no cache
+// o programa pertence ao cache, e não deve ser destruído por quem chama;
+//   é válido até a próxima chamada a cacheprog_pega ou cacheprog_destroi
+// retorna NULL em caso de erro
+programa_t *cacheprog_pega(cacheprog_t *self, char *nome);
+
+// número de vezes que o programa foi encontrado no cache, e número de
+//   vezes que foi necessário ler o arquivo
+int cacheprog_acertos(cacheprog_t *self);
+int cacheprog_faltas(cacheprog_t *self);
+
+#endif // CACHEPROG_H
@@ -0,0 +1,28 @@
+#include "chamada.h"
+#include "so.h"
+#include <stddef.h>
+
+static char *nomes[] = {
+  [SO_LE] = "le",
+  [SO_ESCR] = "escr",
+  [SO_CRIA_PROC] = "cria_proc",
+  [SO_MATA_PROC] = "mata_proc",
+  [SO_ESPERA_PROC] = "espera_proc",
+  [SO_NICE] = "nice",
+  [SO_TEMPO_REAL] = "tempo_real",
+  [SO_ESPERA_PERIODO] = "espera_periodo",
+  [SO_LE_BLOCO] = "le_bloco",
+  [SO_ESCR_BLOCO] = "escr_bloco",
+  [SO_ANEL_REGISTRA] = "anel_registra",
+  [SO_ANEL_ENTRA] = "anel_entra",
+  [SO_DORME] = "dorme",
+  [SO_CONTADOR] = "contador",
+  [SO_CONTADOR_CMD] = "contador_cmd",
+};
+#define N_NOMES (int)(sizeof(nomes) / sizeof(nomes[0]))
+
+char *chamada_nome(int id)
+{
+  if (id < 0 || id >= N_NOMES) return NULL;
+  return nomes[id];
+}
@@ -0,0 +1,10 @@
+#ifndef CHAMADA_H
+#define CHAMADA_H
+
+// nomes das chamadas de sistema (ver so.h), para os relatórios do SO e
+//   para o conversor do rastro de eventos
+
+// retorna o nome da chamada de sistema 'id', ou NULL se não existir
+char *chamada_nome(int id);
+
+#endif // CHAMADA_H
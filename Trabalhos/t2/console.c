@@ -1,4 +1,6 @@
+#define _GNU_SOURCE   // para posix_openpt e companhia
 #include "console.h"
+#include "cronometro.h"
 
 #include <string.h>
 #include <curses.h>  // tomara que eu não me arrependa!
@@ -8,6 +10,8 @@
 #include <stdio.h>
 #include <time.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 
 // tamanho da tela -- a janela do terminal tem que ter pelo menos esse tamanho
@@ -15,8 +19,8 @@
 #define N_COL 80  // número de colunas na tela
 
 // número de linhas para cada componente da tela
-#define N_TERM        4  // número de terminais, cada um ocupa 2 linhas na tela
-#define N_LIN_TERM    (N_TERM * 2)
+#define N_TERM_TELA   4  // número de terminais na tela, cada um ocupa 2 linhas
+#define N_LIN_TERM    (N_TERM_TELA * 2)
 #define N_LIN_STATUS  1
 #define N_LIN_ENTRADA 1
 #define N_LIN_CONSOLE (N_LIN - N_LIN_TERM - N_LIN_STATUS - N_LIN_ENTRADA)
@@ -39,12 +43,27 @@
 // números de comandos para o controlador que podem ser guardados na console
 #define N_CMD_EXT 10
 
+// configuração inicial dos terminais (ver console_configura_terminal)
+#define TAM_ENTRADA_INI  (N_COL - 2)
+#define TAM_SAIDA_INI    1
+#define TICS_POR_CAR_INI 1
+#define LIMIAR_SAIDA_INI 0
+
+// de quantos em quantos tics é verificado se chegou entrada nos terminais
+//   ligados a arquivos do hospedeiro
+#define TICS_VERIFICA_ENTRADA 50
+
+// maior linha dos terminais mostrada na saída padrão, quando não tem tela
+#define TAM_LINHA_SEM_TELA 200
+
 // dados para cada terminal
 typedef struct {
   // texto já digitado no terminal, esperando para ser lido
   char entrada[N_COL+1];
   // texto sendo mostrado na saída do terminal
   char saida[N_COL+1];
+  // linha sendo escrita, quando a console não tem tela
+  char linha[TAM_LINHA_SEM_TELA+1];
   // normal: aceitando novos caracteres na saída
   // rolando: removendo um caractere no início para gerar espaço
   //   o \0 tem a posição do rolamento, move um caractere por vez para
@@ -56,30 +75,91 @@ typedef struct {
   //   entra nesse estado quando recebe um '\n'.
   //   não aceita novos caracteres
   enum { normal, rolando, limpando } estado_saida;
+  // número máximo de caracteres em 'entrada'
+  int tam_entrada;
+  // fila circular dos caracteres escritos que ainda não foram para 'saida'
+  char *fila_saida;
+  int tam_saida;
+  int ini_saida;
+  int n_saida;
+  // velocidade da saída: tics por caractere, e tics que faltam para o
+  //   próximo poder ir para a tela
+  int tics_por_car;
+  int tics_espera;
+  // pede interrupção quando a fila de saída fica com esse tanto, se
+  //   alguém encontrou ela cheia desde a última interrupção
+  int limiar_saida;
+  bool espera_saida;
+  // pedidos de interrupção que ainda não foram atendidos
+  bool irq_teclado;
+  bool irq_tela;
+  // onde o terminal está ligado (ver console_liga_terminal)
+  term_backend_t backend;
+  int fd_entrada;    // -1 se não tiver
+  int fd_saida;      // -1 se não tiver
+  FILE *roteiro;     // entrada do TERM_ROTEIRO
+  char *descricao;   // descrição da ligação, para mostrar na tela
   int cor_txt;
   int cor_cursor;
 } term_t;
 
 struct console_t {
-  term_t term[N_TERM];
+  // se false, não usa o curses: não tem entrada do teclado, e a saída da
+  //   console e as linhas dos terminais da tela vão para a saída padrão
+  bool com_tela;
+  term_t *term;
+  int n_term;
+  int tics;
   char txt_status[N_COL+1];
   char txt_console[N_LIN_CONSOLE][N_COL+1];
   char digitando[N_COL+1];
   char fila_de_comandos_externos[N_CMD_EXT];
+  // número de terminais pedindo interrupção
+  int n_irq_teclado;
+  int n_irq_tela;
 };
 
 // funções auxiliares
 static void init_curses(void);
+static void mostra_na_saida_padrao(console_t *self, int t, char ch);
+static void console_destroi_terminais(console_t *self, int n);
 
-console_t *console_cria(void)
+console_t *console_cria(int n_term, bool com_tela)
 {
+  if (n_term < 1) return NULL;
   console_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
+  self->com_tela = com_tela;
+  self->term = malloc(n_term * sizeof(term_t));
+  if (self->term == NULL) {
+    free(self);
+    return NULL;
+  }
+  self->n_term = n_term;
+  self->tics = 0;
 
-  for (int t=0; t<N_TERM; t++) {
+  for (int t=0; t<n_term; t++) {
     self->term[t].entrada[0] = '\0';
     self->term[t].saida[0] = '\0';
+    self->term[t].linha[0] = '\0';
     self->term[t].estado_saida = normal;
+    self->term[t].fila_saida = NULL;
+    self->term[t].tics_espera = 0;
+    self->term[t].irq_teclado = false;
+    self->term[t].irq_tela = false;
+    // os que cabem na tela são mostrados nela, os outros não são ligados
+    self->term[t].backend = t < N_TERM_TELA ? TERM_CURSES : TERM_NULO;
+    self->term[t].fd_entrada = -1;
+    self->term[t].fd_saida = -1;
+    self->term[t].roteiro = NULL;
+    self->term[t].descricao = NULL;
+    if (!console_configura_terminal(self, t, TAM_ENTRADA_INI, TAM_SAIDA_INI,
+                                    TICS_POR_CAR_INI, LIMIAR_SAIDA_INI)) {
+      console_destroi_terminais(self, t);
+      free(self->term);
+      free(self);
+      return NULL;
+    }
     if (t%2 == 0) {
       self->term[t].cor_txt = COR_TXT_PAR;
       self->term[t].cor_cursor = COR_CURSOR_PAR;
@@ -93,8 +173,10 @@ console_t *console_cria(void)
   }
   self->digitando[0] = '\0';
   self->fila_de_comandos_externos[0] = '\0';
+  self->n_irq_teclado = 0;
+  self->n_irq_tela = 0;
 
-  init_curses();
+  if (self->com_tela) init_curses();
 
   return self;
 }
@@ -119,29 +201,230 @@ static void init_curses(void)
 
 void console_destroi(console_t *self)
 {
-  console_atualiza(self);
-  attron(COLOR_PAIR(COR_OCUPADO));
-  addstr("  digite ENTER para sair  ");
-  while (getch() != '\n') {
-    ;
+  if (self->com_tela) {
+    console_atualiza(self);
+    attron(COLOR_PAIR(COR_OCUPADO));
+    addstr("  digite ENTER para sair  ");
+    while (getch() != '\n') {
+      ;
+    }
+    // acaba com o curses
+    endwin();
+  } else {
+    // mostra o que ficou sem terminar a linha
+    for (int t = 0; t < self->n_term; t++) {
+      if (self->term[t].linha[0] != '\0') mostra_na_saida_padrao(self, t, '\n');
+    }
   }
-  // acaba com o curses
-  endwin();
 
+  console_destroi_terminais(self, self->n_term);
+  free(self->term);
   free(self);
   return;
 }
 
+// desfaz a ligação do terminal 't', que fica como TERM_NULO
+static void desliga_terminal(console_t *self, int t)
+{
+  term_t *termp = &self->term[t];
+  if (termp->fd_entrada != -1) close(termp->fd_entrada);
+  if (termp->fd_saida != -1 && termp->fd_saida != termp->fd_entrada) {
+    close(termp->fd_saida);
+  }
+  if (termp->roteiro != NULL) fclose(termp->roteiro);
+  free(termp->descricao);
+  termp->backend = TERM_NULO;
+  termp->fd_entrada = -1;
+  termp->fd_saida = -1;
+  termp->roteiro = NULL;
+  termp->descricao = NULL;
+}
+
+// libera os recursos dos 'n' primeiros terminais
+static void console_destroi_terminais(console_t *self, int n)
+{
+  for (int t = 0; t < n; t++) {
+    desliga_terminal(self, t);
+    free(self->term[t].fila_saida);
+  }
+}
+
+int console_n_terminais(console_t *self)
+{
+  return self->n_term;
+}
+
+bool console_com_tela(console_t *self)
+{
+  return self->com_tela;
+}
+
+// abre a saída de um terminal ligado a arquivo (se nome não for NULL)
+static bool abre_saida(term_t *termp, char *nome)
+{
+  if (nome == NULL) return true;
+  termp->fd_saida = open(nome, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  return termp->fd_saida != -1;
+}
+
+// liga o terminal a um pseudo-terminal novo do hospedeiro
+static bool abre_pty(term_t *termp)
+{
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd == -1) return false;
+  if (grantpt(fd) == -1 || unlockpt(fd) == -1 || ptsname(fd) == NULL) {
+    close(fd);
+    return false;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  termp->fd_entrada = fd;
+  termp->fd_saida = fd;
+  termp->descricao = strdup(ptsname(fd));
+  return true;
+}
+
+bool console_liga_terminal(console_t *self, int t, term_backend_t backend,
+                           char *entrada, char *saida)
+{
+  if (t < 0 || t >= self->n_term) return false;
+  if (backend == TERM_CURSES && t >= N_TERM_TELA) return false;
+  desliga_terminal(self, t);
+  term_t *termp = &self->term[t];
+  bool ok = true;
+  switch (backend) {
+    case TERM_CURSES:
+    case TERM_NULO:
+      break;
+    case TERM_ARQUIVO:
+      if (entrada != NULL) {
+        // não bloqueia na abertura nem na leitura, para poder ser uma FIFO
+        termp->fd_entrada = open(entrada, O_RDONLY | O_NONBLOCK);
+        ok = termp->fd_entrada != -1;
+      }
+      ok = ok && abre_saida(termp, saida);
+      break;
+    case TERM_ROTEIRO:
+      termp->roteiro = fopen(entrada, "r");
+      ok = termp->roteiro != NULL && abre_saida(termp, saida);
+      break;
+    case TERM_PTY:
+      ok = abre_pty(termp);
+      break;
+    default:
+      ok = false;
+  }
+  if (!ok) {
+    desliga_terminal(self, t);
+    return false;
+  }
+  termp->backend = backend;
+  if (termp->descricao == NULL && entrada != NULL) {
+    termp->descricao = strdup(entrada);
+  }
+  if (termp->backend == TERM_PTY) {
+    console_printf(self, "terminal %d ligado a %s", t, termp->descricao);
+  }
+  return true;
+}
+
+bool console_configura_terminal(console_t *self, int t, int tam_entrada,
+                                int tam_saida, int tics_por_car,
+                                int limiar_saida)
+{
+  if (t < 0 || t >= self->n_term) return false;
+  if (tam_entrada < 1 || tam_entrada > N_COL - 2) return false;
+  if (tam_saida < 1 || tics_por_car < 1) return false;
+  if (limiar_saida < 0 || limiar_saida >= tam_saida) return false;
+  term_t *termp = &self->term[t];
+  // a fila de saída é recriada vazia
+  char *fila = malloc(tam_saida);
+  if (fila == NULL) return false;
+  free(termp->fila_saida);
+  termp->fila_saida = fila;
+  termp->tam_saida = tam_saida;
+  termp->ini_saida = 0;
+  termp->n_saida = 0;
+  termp->tam_entrada = tam_entrada;
+  termp->tics_por_car = tics_por_car;
+  termp->limiar_saida = limiar_saida;
+  termp->espera_saida = false;
+  return true;
+}
+
+// registra um pedido de interrupção do terminal
+// '*pirq' é o pedido do terminal, '*pn' o número de terminais pedindo
+static void pede_irq(bool *pirq, int *pn)
+{
+  // se já tinha pedido, ele vale pelos dois
+  if (*pirq) return;
+  *pirq = true;
+  (*pn)++;
+}
+
+// atende os pedidos de interrupção de todos os terminais
+static void atende_irqs(console_t *self, bool teclado)
+{
+  for (int t = 0; t < self->n_term; t++) {
+    if (teclado) {
+      self->term[t].irq_teclado = false;
+    } else {
+      self->term[t].irq_tela = false;
+    }
+  }
+  if (teclado) {
+    self->n_irq_teclado = 0;
+  } else {
+    self->n_irq_tela = 0;
+  }
+}
+
 
 // SAIDA
 
+// a tela pode mostrar um novo caractere
 static bool pode_imprimir_no_term(console_t *self, int t)
 {
   return self->term[t].estado_saida == normal;
 }
 
+// tem espaço para mais um caractere na fila de saída
+// se não tiver, registra que alguém está esperando, para pedir interrupção
+//   quando esvaziar
+static bool pode_escrever_no_term(console_t *self, int t)
+{
+  term_t *termp = &self->term[t];
+  if (termp->n_saida < termp->tam_saida) return true;
+  termp->espera_saida = true;
+  return false;
+}
+
+static void escreve_no_term(console_t *self, int t, char ch)
+{
+  term_t *termp = &self->term[t];
+  int pos = (termp->ini_saida + termp->n_saida) % termp->tam_saida;
+  termp->fila_saida[pos] = ch;
+  termp->n_saida++;
+}
+
+// sem tela, as linhas escritas nos terminais vão para a saída padrão,
+//   quando completadas
+static void mostra_na_saida_padrao(console_t *self, int t, char ch)
+{
+  term_t *termp = &self->term[t];
+  int tam = strlen(termp->linha);
+  if (ch != '\n') {
+    termp->linha[tam++] = ch;
+    termp->linha[tam] = '\0';
+  }
+  if (ch == '\n' || tam >= TAM_LINHA_SEM_TELA) {
+    printf("%c: %s\n", 'a' + t, termp->linha);
+    termp->linha[0] = '\0';
+  }
+}
+
 static void imprime_no_term(console_t *self, int t, char ch)
 {
+  if (!self->com_tela) mostra_na_saida_padrao(self, t, ch);
   if (pode_imprimir_no_term(self, t)) {
     if (ch == '\n') {
       self->term[t].estado_saida = limpando;
@@ -180,12 +463,39 @@ static void limpa_saida(term_t *termp)
   }
 }
 
+// passa o próximo caractere da fila de saída para a tela, se a tela
+//   estiver pronta e já tiver passado o tempo de um caractere
+static void esvazia_fila_saida(console_t *self, int t)
+{
+  term_t *termp = &self->term[t];
+  if (termp->tics_espera > 0) termp->tics_espera--;
+  if (termp->n_saida == 0 || termp->tics_espera > 0) return;
+  if (!pode_imprimir_no_term(self, t)) return;
+  char ch = termp->fila_saida[termp->ini_saida];
+  termp->ini_saida = (termp->ini_saida + 1) % termp->tam_saida;
+  termp->n_saida--;
+  if (termp->backend == TERM_CURSES) {
+    imprime_no_term(self, t, ch);
+  } else if (termp->fd_saida != -1) {
+    // se o hospedeiro não aceitar, o caractere é perdido
+    if (write(termp->fd_saida, &ch, 1) != 1) {
+      ;
+    }
+  }
+  termp->tics_espera = termp->tics_por_car;
+  if (termp->n_saida <= termp->limiar_saida && termp->espera_saida) {
+    termp->espera_saida = false;
+    pede_irq(&termp->irq_tela, &self->n_irq_tela);
+  }
+}
+
 static void rola_saidas(console_t *self)
 {
-  for (int t = 0; t < N_TERM; t++) {
+  for (int t = 0; t < self->n_term; t++) {
     term_t *termp = &self->term[t];
     switch (termp->estado_saida) {
       case normal: 
+        esvazia_fila_saida(self, t);
         break;
       case rolando:
         rola_saida(termp);
@@ -218,11 +528,46 @@ static void insere_char_no_term(console_t *self, int t, char ch)
 {
   char *p = self->term[t].entrada;
   int tam = strlen(p);
-  if (tam >= N_COL-2) return;
+  if (tam >= self->term[t].tam_entrada) return;
   p[tam] = ch;
   p[tam+1] = '\0';
 }
 
+// traz para a fila de entrada do terminal o que tiver chegado do hospedeiro
+static void le_entrada_do_host(console_t *self, int t)
+{
+  term_t *termp = &self->term[t];
+  int tam = strlen(termp->entrada);
+  int livre = termp->tam_entrada - tam;
+  if (livre <= 0) return;
+  if (termp->roteiro != NULL) {
+    // o roteiro entra uma linha quando a anterior foi toda lida
+    if (tam > 0) return;
+    char linha[N_COL+1];
+    if (fgets(linha, livre + 1, termp->roteiro) == NULL) return;
+    strcpy(termp->entrada, linha);
+  } else if (termp->fd_entrada != -1) {
+    int n = read(termp->fd_entrada, termp->entrada + tam, livre);
+    if (n <= 0) return;
+    termp->entrada[tam + n] = '\0';
+    // o que não for texto é ignorado
+    for (char *p = termp->entrada + tam; *p != '\0'; p++) {
+      if (*p == '\r') *p = '\n';
+      if (*p != '\n' && !isprint((unsigned char)*p)) *p = ' ';
+    }
+  } else {
+    return;
+  }
+  pede_irq(&termp->irq_teclado, &self->n_irq_teclado);
+}
+
+static void le_entradas_do_host(console_t *self)
+{
+  for (int t = 0; t < self->n_term; t++) {
+    if (self->term[t].backend != TERM_CURSES) le_entrada_do_host(self, t);
+  }
+}
+
 
 // CONSOLE
 
@@ -263,6 +608,11 @@ int console_printf(console_t *self, char *formato, ...)
   va_list arg;
   va_start(arg, formato);
   int r = vsnprintf(s, sizeof(s), formato, arg);
+  va_end(arg);
+  if (!self->com_tela) {
+    printf("%s\n", s);
+    return r;
+  }
   insere_strings_na_console(self, s);
   return r;
 }
@@ -270,17 +620,17 @@ int console_printf(console_t *self, char *formato, ...)
 // COMANDO
 
 // retorna o terminal correspondente ao caractere dado, ou -1
-static int term(char c)
+static int term(console_t *self, char c)
 {
   int t = tolower(c) - 'a';
-  if (t >= 0 && t < N_TERM) return t;
+  if (t >= 0 && t < self->n_term) return t;
   return -1;
 }
 
 static void insere_str_no_term(console_t *self, char c, char *str)
 {
   // insere caracteres no terminal (e espaço no final)
-  int t = term(c);
+  int t = term(self, c);
   if (t == -1) {
     console_printf(self, "Terminal '%c' inválido\n", c);
     return;
@@ -291,11 +641,36 @@ static void insere_str_no_term(console_t *self, char c, char *str)
     p++;
   }
   insere_char_no_term(self, t, ' ');
+  pede_irq(&self->term[t].irq_teclado, &self->n_irq_teclado);
+}
+
+// insere o texto no terminal, exatamente como está, a não ser pelas
+//   sequências \n, \t e \\, que são trocadas pelo caractere correspondente
+static void insere_texto_no_term(console_t *self, char c, char *str)
+{
+  int t = term(self, c);
+  if (t == -1) {
+    console_printf(self, "Terminal '%c' inválido\n", c);
+    return;
+  }
+  for (char *p = str; *p != '\0'; p++) {
+    char ch = *p;
+    if (ch == '\\' && p[1] != '\0') {
+      p++;
+      switch (*p) {
+        case 'n': ch = '\n'; break;
+        case 't': ch = '\t'; break;
+        default:  ch = *p;
+      }
+    }
+    insere_char_no_term(self, t, ch);
+  }
+  pede_irq(&self->term[t].irq_teclado, &self->n_irq_teclado);
 }
 
 static void limpa_saida_do_term(console_t *self, char c)
 {
-  int t = term(c);
+  int t = term(self, c);
   if (t == -1) {
     console_printf(self, "Terminal '%c' inválido\n", c);
     return;
@@ -323,11 +698,13 @@ static char remove_comando_externo(console_t *self)
   return cmd;
 }
 
-static void interpreta_entrada(console_t *self)
+static void interpreta_entrada(console_t *self, char *linha)
 {
   // interpreta uma linha digitada pelo operador
   // Comandos aceitos:
   // Etstr entra a string 'str' no terminal 't'  ex: eb30
+  // Dtstr digita a string 'str' no terminal 't', sem o espaço no final,
+  //       com \n para enter  ex: db42\n
   // Zt    esvazia a saída do terminal 't'  ex: za
   // P     para a execução
   // 1     executa uma instrução
@@ -335,13 +712,16 @@ static void interpreta_entrada(console_t *self)
   // F     fim da simulação
   // retorna o caractere correspondente ao comando se não tratar localmente
   //   (comandos de controle da execução), ou '\0'
-  char *linha = self->digitando;
   console_printf(self, "%s", linha);
   char cmd = toupper(linha[0]);
+  if (cmd == '\0') return;
   switch (cmd) {
     case 'E':
       insere_str_no_term(self, linha[1], &linha[2]);
       break;
+    case 'D':
+      insere_texto_no_term(self, linha[1], &linha[2]);
+      break;
     case 'Z':
       limpa_saida_do_term(self, linha[1]);
       break;
@@ -354,12 +734,17 @@ static void interpreta_entrada(console_t *self)
     default:
       console_printf(self, "Comando '%c' não reconhecido", cmd);
   }
-  self->digitando[0] = '\0';
+}
+
+void console_executa_comando(console_t *self, char *linha)
+{
+  interpreta_entrada(self, linha);
 }
 
 // lê e guarda um caractere do teclado; interpreta linha se for 'enter'
 static void verifica_entrada(console_t *self)
 {
+  if (!self->com_tela) return;
   int ch = getch();
   if (ch == ERR) return;
   int l = strlen(self->digitando);
@@ -368,7 +753,8 @@ static void verifica_entrada(console_t *self)
       self->digitando[l-1] = '\0';
     }
   } else if (ch == '\n') {
-    interpreta_entrada(self);
+    interpreta_entrada(self, self->digitando);
+    self->digitando[0] = '\0';
   } else if (ch >= ' ' && ch < 127 && l < N_COL) {
     self->digitando[l] = ch;
     self->digitando[l+1] = '\0';
@@ -396,13 +782,36 @@ static void desenha_terminal(term_t *termp, int linha)
   attroff(COLOR_PAIR(termp->cor_cursor));
 }
 
+// um terminal que não está ligado na tela mostra a sua ligação
+static void desenha_ligacao(term_t *termp, int t, int linha)
+{
+  static char *nomes[] = {
+    [TERM_CURSES] = "tela", [TERM_NULO] = "nada", [TERM_ARQUIVO] = "arquivo",
+    [TERM_PTY] = "pty", [TERM_ROTEIRO] = "roteiro",
+  };
+  mvprintw(linha, 0, "%-*s", N_COL, "");
+  mvprintw(linha, 0, "[terminal %c ligado a %s %s]", 'a' + t,
+           nomes[termp->backend],
+           termp->descricao == NULL ? "" : termp->descricao);
+  mvprintw(linha + 1, 0, "%-*s", N_COL, "");
+}
+
 static void desenha_terminais(console_t *self)
 {
-  for (int t=0; t<N_TERM; t++) {
-    term_t *termp = &self->term[t];
+  for (int t=0; t<N_TERM_TELA; t++) {
     int linha = LINHA_TERM + t*2;
+    if (t >= self->n_term) {
+      mvprintw(linha, 0, "%-*s", N_COL, "");
+      mvprintw(linha + 1, 0, "%-*s", N_COL, "");
+      continue;
+    }
+    term_t *termp = &self->term[t];
     attron(COLOR_PAIR(termp->cor_txt));
-    desenha_terminal(termp, linha);
+    if (termp->backend == TERM_CURSES) {
+      desenha_terminal(termp, linha);
+    } else {
+      desenha_ligacao(termp, t, linha);
+    }
     attroff(COLOR_PAIR(termp->cor_txt));
   }
 }
@@ -428,7 +837,7 @@ static void desenha_entrada(console_t *self)
 {
   attron(COLOR_PAIR(COR_ENTRADA));
   mvprintw(LINHA_ENTRADA, 0, "%*s", N_COL, 
-           "P=para C=continua 1=passo F=fim  Ets=entra Zt=zera");
+           "P=para C=continua 1=passo F=fim  Ets=entra Dts=digita Zt=zera");
   mvprintw(LINHA_ENTRADA, 0, "%s", self->digitando);
   attroff(COLOR_PAIR(COR_ENTRADA));
 }
@@ -443,10 +852,14 @@ void console_tictac(console_t *self)
 {
   verifica_entrada(self);
   rola_saidas(self);
+  self->tics++;
+  if (self->tics % TICS_VERIFICA_ENTRADA == 0) le_entradas_do_host(self);
 }
 
 void console_atualiza(console_t *self)
 {
+  if (!self->com_tela) return;
+  CRONO_ENTRA(CRONO_CONSOLE);
   desenha_terminais(self);
   desenha_status(self);
   desenha_console(self);
@@ -454,17 +867,25 @@ void console_atualiza(console_t *self)
 
   // manda o curses fazer aparecer tudo isso
   refresh();
+  CRONO_SAI(CRONO_CONSOLE);
 }
 
 
 err_t term_le(void *disp, int id, int *pvalor)
 {
   console_t *self = disp;
+  if (id == CONSOLE_IRQ_TECLADO) {
+    *pvalor = self->n_irq_teclado;
+    return ERR_OK;
+  } else if (id == CONSOLE_IRQ_TELA) {
+    *pvalor = self->n_irq_tela;
+    return ERR_OK;
+  }
   // cada terminal tem 4 dispositivos:
   //   leitura, estado da leitura, escrita, estado da escrita
   int term = id / 4;
   int sub = id % 4;
-  if (term < 0 || term >= N_TERM) return ERR_DISP_INV;
+  if (term < 0 || term >= self->n_term) return ERR_DISP_INV;
   switch (sub) {
     case 0: // leitura do teclado
       if (!tem_char_no_term(self, term)) return ERR_OCUP;
@@ -481,7 +902,7 @@ err_t term_le(void *disp, int id, int *pvalor)
       return ERR_OP_INV;
       break;
     case 3: // estado da tela
-      if (pode_imprimir_no_term(self, term)) {
+      if (pode_escrever_no_term(self, term)) {
         *pvalor = 1;
       } else {
         *pvalor = 0;
@@ -494,11 +915,16 @@ err_t term_le(void *disp, int id, int *pvalor)
 err_t term_escr(void *disp, int id, int valor)
 {
   console_t *self = disp;
+  if (id == CONSOLE_IRQ_TECLADO || id == CONSOLE_IRQ_TELA) {
+    if (valor != 0) return ERR_OP_INV;
+    atende_irqs(self, id == CONSOLE_IRQ_TECLADO);
+    return ERR_OK;
+  }
   // cada terminal tem 4 dispositivos:
   //   leitura, estado da leitura, escrita, estado da escrita
   int term = id / 4;
   int sub = id % 4;
-  if (term < 0 || term >= N_TERM) return ERR_DISP_INV;
+  if (term < 0 || term >= self->n_term) return ERR_DISP_INV;
   switch (sub) {
     case 0: // leitura do teclado
       return ERR_OP_INV;
@@ -507,8 +933,8 @@ err_t term_escr(void *disp, int id, int valor)
       return ERR_OP_INV;
       break;
     case 2: // escrita na tela
-      if (!pode_imprimir_no_term(self, term)) return ERR_OCUP;
-      imprime_no_term(self, term, valor);
+      if (!pode_escrever_no_term(self, term)) return ERR_OCUP;
+      escreve_no_term(self, term, valor);
       break;
     case 3: // estado da tela
       return ERR_OP_INV;
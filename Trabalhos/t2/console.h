@@ -9,25 +9,81 @@
 //   colocado após a letra, será inserido um enter)
 //
 // além da saída em cada terminal, tem a saída da console, com t_printf (para debug)
+//
+// cada terminal tem uma fila de entrada, com os caracteres digitados que
+//   ainda não foram lidos, e uma fila de saída, com os caracteres escritos
+//   que ainda não apareceram na tela; os caracteres da fila de saída vão
+//   para a tela na velocidade do terminal
+// a console pede interrupção de teclado quando chegam caracteres em um
+//   terminal, e de tela quando a fila de saída de um terminal, que foi
+//   encontrada cheia, esvazia até um limiar; cada terminal mantém um
+//   pedido de cada tipo, e pedidos que chegam antes de o anterior ser
+//   atendido são reunidos nele
 
 #include <stdbool.h>
 #include "es.h"
 
 typedef struct console_t console_t;
 
-// cria e inicializa a console
+// onde um terminal pode estar ligado
+typedef enum {
+  TERM_CURSES,   // área do terminal na tela da console (só os 4 primeiros)
+  TERM_NULO,     // nada: sem entrada, a saída é descartada
+  TERM_ARQUIVO,  // arquivos (ou FIFOs) do hospedeiro para entrada e saída
+  TERM_PTY,      // um pseudo-terminal do hospedeiro, criado na ligação
+  TERM_ROTEIRO,  // entrada de um arquivo, uma linha por vez: a próxima
+                 //   linha entra quando a anterior foi toda lida
+} term_backend_t;
+
+// cria e inicializa a console, com 'n_term' terminais
+// os terminais que cabem na tela são ligados a ela (TERM_CURSES), os
+//   outros não são ligados (TERM_NULO)
+// se 'com_tela' for false, a console não usa a tela nem o teclado: as
+//   mensagens da console e as linhas escritas nos terminais que seriam
+//   mostrados na tela vão para a saída padrão, e os comandos só podem vir
+//   de console_executa_comando
 // retorna NULL em caso de erro
-console_t *console_cria(void);
+console_t *console_cria(int n_term, bool com_tela);
 
 // destrói a console
 void console_destroi(console_t *self);
 
+// retorna o número de terminais
+int console_n_terminais(console_t *self);
+
+// retorna true se a console usa a tela e o teclado
+bool console_com_tela(console_t *self);
+
+// liga o terminal 't' a um backend
+// 'entrada' e 'saida' são os nomes dos arquivos do hospedeiro usados para
+//   a entrada e a saída do terminal, para TERM_ARQUIVO e TERM_ROTEIRO; um
+//   deles pode ser NULL, se não for usado (a entrada do roteiro é
+//   obrigatória)
+// a entrada dos terminais que não estão na tela é verificada
+//   periodicamente, sem bloquear
+// retorna false se não foi possível ligar
+bool console_liga_terminal(console_t *self, int t, term_backend_t backend,
+                           char *entrada, char *saida);
+
+// configura o terminal 't' (0 para o primeiro)
+// tam_entrada e tam_saida são as capacidades das filas de entrada e saída,
+//   tics_por_car é o número de tics para cada caractere da fila de saída
+//   ir para a tela, e limiar_saida é o número de caracteres na fila de
+//   saída em que é pedida interrupção, quando ela está esvaziando
+// retorna false se os valores forem inválidos
+bool console_configura_terminal(console_t *self, int t, int tam_entrada,
+                                int tam_saida, int tics_por_car,
+                                int limiar_saida);
+
 // imprime na área geral do console
 int console_printf(console_t *self, char *fmt, ...);
 
 // imprime na linha de status
 void console_print_status(console_t *self, char *txt);
 
+// executa um comando, como se tivesse sido digitado pelo operador
+void console_executa_comando(console_t *self, char *linha);
+
 // função chamada para receber comandos externos da console
 // retorna um char que representa um comando do usuário que deve ser
 //   tratado fora da console (atualmente 'P', '1' ou 'C' - para, executa 1 instrução
@@ -42,6 +98,16 @@ void console_atualiza(console_t *self);
 
 // Funções para implementar o protocolo de acesso a um dispositivo pelo
 //   controlador de E/S
+//   cada terminal t tem quatro dispositivos, a partir de t*4:
+//   '0' para ler um caractere do teclado
+//   '1' para ler se tem caractere para ler no teclado
+//   '2' para escrever um caractere na tela
+//   '3' para ler se tem espaço na fila de saída
+//   além desses, tem os dispositivos abaixo, para ler quantos terminais
+//   estão pedindo interrupção, ou escrever 0 para atender os pedidos de
+//   todos eles
+#define CONSOLE_IRQ_TECLADO -1
+#define CONSOLE_IRQ_TELA    -2
 err_t term_le(void *disp, int id, int *pvalor);
 err_t term_escr(void *disp, int id, int valor);
 
@@ -0,0 +1,157 @@
+#include "contadores.h"
+#include "instrucao.h"
+#include "irq.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// um a mais que o maior número de contador
+#define CONT_N CONT_OPCODE(N_OPCODE)
+
+// os valores lidos são os da CPU e da MMU (que contam desde a criação), ou
+//   o das faltas informadas pelo SO, menos a base, que muda quando os contadores são zerados ou
+//   descongelados
+struct contadores_t {
+  cpu_t *cpu;
+  mmu_t *mmu;
+  long n_faltas;        // informadas pelo SO
+  long base[CONT_N];
+  bool congelado;
+  long congelados[CONT_N];  // os valores no congelamento (sem a base)
+  // estado do dispositivo
+  int selecao;
+  int valor_alto;
+};
+
+static bool cont_valido(int contador)
+{
+  if (contador >= CONT_INSTRUCOES && contador <= CONT_INTERRUPCOES) {
+    return true;
+  }
+  if (contador >= CONT_IRQ(0) && contador < CONT_IRQ(N_IRQ)) return true;
+  return contador >= CONT_OPCODE(0) && contador < CONT_OPCODE(N_OPCODE);
+}
+
+// o valor do contador na CPU ou na MMU
+static long cont_bruto(contadores_t *self, int contador)
+{
+  switch (contador) {
+    case CONT_INSTRUCOES:
+      return cpu_n_instrucoes(self->cpu, -1);
+    case CONT_FALTAS:
+      return self->n_faltas;
+    case CONT_TRADUCOES:
+      return mmu_n_traducoes(self->mmu);
+    case CONT_INTERRUPCOES:
+      return cpu_n_interrupcoes(self->cpu, -1);
+  }
+  if (contador < CONT_OPCODE(0)) {
+    return cpu_n_interrupcoes(self->cpu, contador - CONT_IRQ(0));
+  }
+  return cpu_n_instrucoes(self->cpu, contador - CONT_OPCODE(0));
+}
+
+contadores_t *cont_cria(cpu_t *cpu, mmu_t *mmu)
+{
+  contadores_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->cpu = cpu;
+  self->mmu = mmu;
+  self->n_faltas = 0;
+  self->congelado = false;
+  self->selecao = CONT_INSTRUCOES;
+  self->valor_alto = 0;
+  cont_comando(self, CONT_ZERA);
+  return self;
+}
+
+void cont_destroi(contadores_t *self)
+{
+  free(self);
+}
+
+bool cont_valor(contadores_t *self, int contador, long *pvalor)
+{
+  if (!cont_valido(contador)) return false;
+  if (self->congelado) {
+    *pvalor = self->congelados[contador] - self->base[contador];
+  } else {
+    *pvalor = cont_bruto(self, contador) - self->base[contador];
+  }
+  return true;
+}
+
+void cont_conta_falta(contadores_t *self)
+{
+  self->n_faltas++;
+}
+
+bool cont_comando(contadores_t *self, int comando)
+{
+  for (int c = 0; c < CONT_N; c++) {
+    if (!cont_valido(c)) continue;
+    switch (comando) {
+      case CONT_ZERA:
+        // congelado, zera o valor congelado
+        self->base[c] = self->congelado ? self->congelados[c]
+                                        : cont_bruto(self, c);
+        break;
+      case CONT_CONGELA:
+        if (!self->congelado) self->congelados[c] = cont_bruto(self, c);
+        break;
+      case CONT_DESCONGELA:
+        // o que foi contado durante o congelamento é descontado
+        if (self->congelado) {
+          self->base[c] += cont_bruto(self, c) - self->congelados[c];
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+  if (comando == CONT_CONGELA) self->congelado = true;
+  if (comando == CONT_DESCONGELA) self->congelado = false;
+  return true;
+}
+
+err_t cont_le(void *disp, int id, int *pvalor)
+{
+  contadores_t *self = disp;
+  long valor;
+  switch (id) {
+    case CONT_SELECAO:
+      *pvalor = self->selecao;
+      break;
+    case CONT_VALOR:
+      cont_valor(self, self->selecao, &valor);
+      *pvalor = (int32_t)valor;
+      self->valor_alto = (int32_t)((int64_t)valor >> 32);
+      break;
+    case CONT_VALOR_ALTO:
+      *pvalor = self->valor_alto;
+      break;
+    case CONT_COMANDO:
+      *pvalor = self->congelado ? 1 : 0;
+      break;
+    default:
+      return ERR_OP_INV;
+  }
+  return ERR_OK;
+}
+
+err_t cont_escr(void *disp, int id, int valor)
+{
+  contadores_t *self = disp;
+  switch (id) {
+    case CONT_SELECAO:
+      if (!cont_valido(valor)) return ERR_OP_INV;
+      self->selecao = valor;
+      break;
+    case CONT_COMANDO:
+      if (!cont_comando(self, valor)) return ERR_OP_INV;
+      break;
+    default:
+      return ERR_OP_INV;
+  }
+  return ERR_OK;
+}
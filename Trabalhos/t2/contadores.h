@@ -0,0 +1,86 @@
+#ifndef CONTADORES_H
+#define CONTADORES_H
+
+// contadores de desempenho
+// dispositivo que permite ao programa da máquina simulada medir a própria
+//   execução, lendo contadores mantidos pela CPU e pela MMU
+// os contadores são da máquina, não de um processo: contam tudo o que a
+//   CPU executa, inclusive o SO
+// os contadores podem ser zerados e congelados; enquanto congelados, a
+//   leitura dá sempre o valor do momento do congelamento, e o que acontece
+//   até o descongelamento não é contado
+
+#include <stdbool.h>
+#include "err.h"
+#include "cpu.h"
+#include "mmu.h"
+
+// os contadores
+//   CONT_INSTRUCOES      instruções executadas sem erro
+//   CONT_FALTAS          faltas de página atendidas pelo SO (que as
+//                        informa com cont_conta_falta), inclusive as dos
+//                        acessos do SO à memória dos processos
+//   CONT_TRADUCOES       traduções de endereço feitas pela MMU nos acessos
+//                        da CPU (não conta as cópias em bloco do SO); como
+//                        a MMU não tem TLB, cada uma é uma consulta à
+//                        tabela de páginas (equivalem às faltas de TLB)
+//   CONT_INTERRUPCOES    interrupções aceitas pela CPU
+//   CONT_IRQ(irq)        interrupções aceitas, do tipo 'irq' (ver irq.h)
+//   CONT_OPCODE(op)      instruções executadas sem erro, com o opcode 'op'
+//                        (ver instrucao.h)
+// os números que não correspondem a nenhum contador são inválidos
+#define CONT_INSTRUCOES     0
+#define CONT_FALTAS         1
+#define CONT_TRADUCOES      2
+#define CONT_INTERRUPCOES   3
+#define CONT_IRQ(irq)       (16 + (irq))
+#define CONT_OPCODE(op)     (48 + (op))
+
+// os comandos
+//   CONT_ZERA            zera todos os contadores
+//   CONT_CONGELA         congela os contadores
+//   CONT_DESCONGELA      volta a contar
+#define CONT_ZERA           0
+#define CONT_CONGELA        1
+#define CONT_DESCONGELA     2
+
+typedef struct contadores_t contadores_t;
+
+// cria os contadores, que leem a CPU 'cpu' e a MMU 'mmu'
+// os contadores começam zerados
+// retorna NULL em caso de erro
+contadores_t *cont_cria(cpu_t *cpu, mmu_t *mmu);
+
+// destrói os contadores
+void cont_destroi(contadores_t *self);
+
+// coloca em *pvalor o valor do contador 'contador'
+// retorna false se o contador for inválido
+bool cont_valor(contadores_t *self, int contador, long *pvalor);
+
+// informa que o SO atendeu uma falta de página
+// a falta é detectada pela MMU, mas só o SO sabe quais são atendidas (um
+//   acesso fora do espaço do processo também é detectado, mas mata ele)
+void cont_conta_falta(contadores_t *self);
+
+// executa o comando 'comando'
+// retorna false se o comando for inválido
+bool cont_comando(contadores_t *self, int comando);
+
+// Funções para acessar os contadores como um dispositivo de E/S
+//   CONT_SELECAO         escreve o número do contador a ler; lê o número
+//                        selecionado
+//   CONT_VALOR           lê os 32 bits de baixo do contador selecionado;
+//                        os 32 de cima são guardados, para serem lidos em
+//                        CONT_VALOR_ALTO
+//   CONT_COMANDO         escreve um comando; lê se os contadores estão
+//                        congelados (1) ou não (0)
+// escrever um contador ou comando inválido é um erro (ERR_OP_INV)
+#define CONT_SELECAO        0
+#define CONT_VALOR          1
+#define CONT_VALOR_ALTO     2
+#define CONT_COMANDO        3
+err_t cont_le(void *disp, int id, int *pvalor);
+err_t cont_escr(void *disp, int id, int valor);
+
+#endif // CONTADORES_H
@@ -4,14 +4,29 @@
 #include <string.h>
 #include <stdio.h>
 
+// maior número de instruções executadas de uma vez, sem atender os
+//   comandos do operador nem redesenhar a tela
+#define LOTE_MAX 100
+
+// a interrupção pedida por cada canal do relógio
+static const irq_t irq_do_canal[REL_N_CANAIS] = {
+  IRQ_RELOGIO, IRQ_RELOGIO_1, IRQ_RELOGIO_2, IRQ_RELOGIO_3
+};
+
 struct controle_t {
   cpu_t *cpu;
   relogio_t *relogio;
   console_t *console;
+  injetor_t *injetor;
+  metricas_t *metricas;
+  amostrador_t *amostrador;
+  // se algum canal do relógio estava pedindo interrupção no fim do lote
+  bool relogio_pedindo;
   enum { executando, passo, parado, fim } estado;
 };
 
 // funções auxiliares
+static void controle_executa_lote(controle_t *self);
 static void controle_processa_teclado(controle_t *self);
 static void controle_atualiza_console(controle_t *self);
 
@@ -24,7 +39,12 @@ controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
   self->cpu = cpu;
   self->console = console;
   self->relogio = relogio;
-  self->estado = parado;
+  self->injetor = NULL;
+  self->metricas = NULL;
+  self->amostrador = NULL;
+  self->relogio_pedindo = false;
+  // sem tela, não tem como o operador mandar continuar
+  self->estado = console_com_tela(console) ? parado : executando;
 
   return self;
 }
@@ -34,28 +54,116 @@ void controle_destroi(controle_t *self)
   free(self);
 }
 
+void controle_define_injetor(controle_t *self, injetor_t *injetor)
+{
+  self->injetor = injetor;
+}
+
+void controle_define_metricas(controle_t *self, metricas_t *metricas)
+{
+  self->metricas = metricas;
+}
+
+void controle_define_amostrador(controle_t *self, amostrador_t *amostrador)
+{
+  self->amostrador = amostrador;
+}
+
 void controle_laco(controle_t *self)
 {
-  // executa uma instrução por vez até a console dizer que chega
+  // executa instruções até a console dizer que chega
   do {
     if (self->estado == passo || self->estado == executando) {
-      cpu_executa_1(self->cpu);
-      rel_tictac(self->relogio);
-      console_tictac(self->console);
-      // enquanto não tem controlador de interrupção, fala direto com o relógio
-      // o dispositivo 3 do relógio contém 1 se o timer expirou
-      int tem_int;
-      rel_le(self->relogio, 3, &tem_int);
-      if (tem_int != 0) {
-        cpu_interrompe(self->cpu, IRQ_RELOGIO);
-      }
+      controle_executa_lote(self);
+    }
+    if (self->injetor != NULL) {
+      inj_executa(self->injetor, rel_agora(self->relogio));
     }
+    if (self->metricas != NULL) met_atualiza(self->metricas);
     controle_processa_teclado(self);
-    controle_atualiza_console(self);
+    if (console_com_tela(self->console)) controle_atualiza_console(self);
   } while (self->estado != fim);
 
   console_printf(self->console, "Fim da execução.");
-  console_printf(self->console, "relógio: %d\n", rel_agora(self->relogio));
+  console_printf(self->console, "relógio: %ld\n", rel_agora(self->relogio));
+}
+
+// pede à CPU as interrupções dos canais do relógio que estão pedindo
+// retorna true se algum canal está pedindo
+static bool controle_verifica_relogio(controle_t *self)
+{
+  bool tem = false;
+  for (int c = 0; c < REL_N_CANAIS; c++) {
+    int tem_int;
+    rel_le(self->relogio, REL_INTERRUPCAO(c), &tem_int);
+    if (tem_int != 0) {
+      cpu_interrompe(self->cpu, irq_do_canal[c]);
+      tem = true;
+    }
+  }
+  return tem;
+}
+
+// calcula até quando pode executar sem olhar o roteiro e os comandos do
+//   operador: até o próximo evento do roteiro ou a próxima amostra,
+//   limitado a LOTE_MAX instruções (o lote também termina no prazo do
+//   relógio)
+// um pedido do relógio que não foi aceito pela CPU continua sendo pedido,
+//   e é verificado de novo depois da próxima instrução
+static long controle_fim_do_lote(controle_t *self)
+{
+  long agora = rel_agora(self->relogio);
+  if (self->estado == passo || self->relogio_pedindo) return agora + 1;
+  long fim = agora + LOTE_MAX;
+  long momento;
+  if (self->injetor != NULL && inj_proximo(self->injetor, &momento)
+      && momento < fim) {
+    fim = momento;
+  }
+  if (self->amostrador != NULL && amo_proxima(self->amostrador) < fim) {
+    fim = amo_proxima(self->amostrador);
+  }
+  return fim > agora ? fim : agora + 1;
+}
+
+// executa instruções em lote
+// os pedidos de interrupção da console são verificados a cada instrução;
+//   os do relógio só mudam no prazo dele, e são verificados no fim do lote,
+//   que não passa do prazo (que é consultado depois de cada instrução,
+//   porque o SO pode reprogramar o relógio)
+static void controle_executa_lote(controle_t *self)
+{
+  long fim = controle_fim_do_lote(self);
+  bool ultima;
+  do {
+    cpu_executa_1(self->cpu);
+    long prazo = rel_proximo_prazo(self->relogio);
+    if (prazo != -1 && prazo < fim) fim = prazo;
+    rel_tictac(self->relogio);
+    console_tictac(self->console);
+    // enquanto não tem controlador de interrupção, fala direto com os
+    //   dispositivos
+    // a CPU só aceita uma interrupção por vez; as outras continuam sendo
+    //   pedidas, e vão ser aceitas depois que a primeira for atendida
+    ultima = rel_agora(self->relogio) >= fim;
+    if (ultima) {
+      // a amostra é do estado antes de aceitar as interrupções do relógio
+      if (self->amostrador != NULL
+          && rel_agora(self->relogio) >= amo_proxima(self->amostrador)) {
+        amo_amostra(self->amostrador, rel_agora(self->relogio));
+      }
+      self->relogio_pedindo = controle_verifica_relogio(self);
+    }
+    int tem_int;
+    term_le(self->console, CONSOLE_IRQ_TECLADO, &tem_int);
+    if (tem_int != 0) {
+      cpu_interrompe(self->cpu, IRQ_TECLADO);
+    }
+    term_le(self->console, CONSOLE_IRQ_TELA, &tem_int);
+    if (tem_int != 0) {
+      cpu_interrompe(self->cpu, IRQ_TELA);
+    }
+  } while (!ultima);
 }
  
 
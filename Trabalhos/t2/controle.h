@@ -13,10 +13,28 @@ typedef struct controle_t controle_t;
 #include "cpu.h"
 #include "console.h"
 #include "relogio.h"
+#include "injetor.h"
+#include "metricas.h"
+#include "amostrador.h"
 
 controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio);
 void controle_destroi(controle_t *self);
 
+// define o injetor de eventos, cujos eventos são executados quando o
+//   relógio chegar no momento deles (NULL se não tiver)
+// o injetor continua pertencendo a quem chama
+void controle_define_injetor(controle_t *self, injetor_t *injetor);
+
+// define o exportador de métricas, atualizado a cada passo do laço da
+//   simulação (NULL se não tiver)
+// o exportador continua pertencendo a quem chama
+void controle_define_metricas(controle_t *self, metricas_t *metricas);
+
+// define o amostrador, chamado no momento de cada amostra (NULL se não
+//   tiver)
+// o amostrador continua pertencendo a quem chama
+void controle_define_amostrador(controle_t *self, amostrador_t *amostrador);
+
 // o laço principal da simulação
 void controle_laco(controle_t *self);
 
@@ -1,5 +1,6 @@
 #include "cpu.h"
 #include "instrucao.h"
+#include "cronometro.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -22,6 +23,12 @@ struct cpu_t {
   // função e argumento para implementar instrução CHAMAC
   func_chamaC_t funcaoC;
   void *argC;
+  // contadores, para as métricas
+  long n_instrucoes;    // instruções executadas sem erro
+  long n_opcode[N_OPCODE];     // as mesmas, por opcode
+  long n_interrupcoes[N_IRQ];  // interrupções aceitas
+  // perfil de execução, ou NULL
+  perfil_t *perfil;
 };
 
 cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
@@ -39,6 +46,14 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
     self->complemento = 0;
     self->modo = supervisor;
     self->funcaoC = NULL;
+    self->perfil = NULL;
+    self->n_instrucoes = 0;
+    for (int op = 0; op < N_OPCODE; op++) {
+      self->n_opcode[op] = 0;
+    }
+    for (int irq = 0; irq < N_IRQ; irq++) {
+      self->n_interrupcoes[irq] = 0;
+    }
     // gera uma interrupção de reset
     cpu_interrompe(self, IRQ_RESET);
   }
@@ -388,45 +403,58 @@ void cpu_executa_1(cpu_t *self)
 {
   // não executa se CPU já estiver em erro
   if (self->erro != ERR_OK) return;
+  CRONO_ENTRA(CRONO_CPU);
 
+  // se não conseguir ler o opcode (falta de página, por exemplo), o erro
+  //   tem que causar interrupção como nas demais instruções
   int opcode;
-  if (!pega_opcode(self, &opcode)) return;
-
-  switch (opcode) {
-    case NOP:    op_NOP(self);    break;
-    case PARA:   op_PARA(self);   break;
-    case CARGI:  op_CARGI(self);  break;
-    case CARGM:  op_CARGM(self);  break;
-    case CARGX:  op_CARGX(self);  break;
-    case ARMM:   op_ARMM(self);   break;
-    case ARMX:   op_ARMX(self);   break;
-    case TRAX:   op_TRAX(self);   break;
-    case CPXA:   op_CPXA(self);   break;
-    case INCX:   op_INCX(self);   break;
-    case SOMA:   op_SOMA(self);   break;
-    case SUB:    op_SUB(self);    break;
-    case MULT:   op_MULT(self);   break;
-    case DIV:    op_DIV(self);    break;
-    case RESTO:  op_RESTO(self);  break;
-    case NEG:    op_NEG(self);    break;
-    case DESV:   op_DESV(self);   break;
-    case DESVZ:  op_DESVZ(self);  break;
-    case DESVNZ: op_DESVNZ(self); break;
-    case DESVN:  op_DESVN(self);  break;
-    case DESVP:  op_DESVP(self);  break;
-    case CHAMA:  op_CHAMA(self);  break;
-    case RET:    op_RET(self);    break;
-    case LE:     op_LE(self);     break;
-    case ESCR:   op_ESCR(self);   break;
-    case RETI:   op_RETI(self);   break;
-    case CHAMAC: op_CHAMAC(self); break;
-    case CHAMAS: op_CHAMAS(self); break;
-    default:     self->erro = ERR_INSTR_INV;
-  }
-
-  if (self->erro != ERR_OK && self->erro != ERR_CPU_PARADA && self->modo == usuario) {
+  int pc = self->PC;
+  cpu_modo_t modo = self->modo;
+  if (pega_opcode(self, &opcode)) {
+    switch (opcode) {
+      case NOP:    op_NOP(self);    break;
+      case PARA:   op_PARA(self);   break;
+      case CARGI:  op_CARGI(self);  break;
+      case CARGM:  op_CARGM(self);  break;
+      case CARGX:  op_CARGX(self);  break;
+      case ARMM:   op_ARMM(self);   break;
+      case ARMX:   op_ARMX(self);   break;
+      case TRAX:   op_TRAX(self);   break;
+      case CPXA:   op_CPXA(self);   break;
+      case INCX:   op_INCX(self);   break;
+      case SOMA:   op_SOMA(self);   break;
+      case SUB:    op_SUB(self);    break;
+      case MULT:   op_MULT(self);   break;
+      case DIV:    op_DIV(self);    break;
+      case RESTO:  op_RESTO(self);  break;
+      case NEG:    op_NEG(self);    break;
+      case DESV:   op_DESV(self);   break;
+      case DESVZ:  op_DESVZ(self);  break;
+      case DESVNZ: op_DESVNZ(self); break;
+      case DESVN:  op_DESVN(self);  break;
+      case DESVP:  op_DESVP(self);  break;
+      case CHAMA:  op_CHAMA(self);  break;
+      case RET:    op_RET(self);    break;
+      case LE:     op_LE(self);     break;
+      case ESCR:   op_ESCR(self);   break;
+      case RETI:   op_RETI(self);   break;
+      case CHAMAC: op_CHAMAC(self); break;
+      case CHAMAS: op_CHAMAS(self); break;
+      default:     self->erro = ERR_INSTR_INV;
+    }
+  }
+
+  if (self->erro == ERR_OK) {
+    self->n_instrucoes++;
+    self->n_opcode[opcode]++;
+    if (self->perfil != NULL) {
+      bool desviou = self->PC != pc + 1 + instrucao_num_args(opcode);
+      perfil_conta(self->perfil, modo, pc, opcode, desviou);
+    }
+  } else if (self->erro != ERR_CPU_PARADA && self->modo == usuario) {
     cpu_interrompe(self, IRQ_ERR_CPU);
   }
+  CRONO_SAI(CRONO_CPU);
 }
 
 bool cpu_interrompe(cpu_t *self, irq_t irq)
@@ -435,32 +463,39 @@ bool cpu_interrompe(cpu_t *self, irq_t irq)
   if (self->modo != usuario) return false;
   // esta é uma CPU boazinha, salva todo o estado interno da CPU
   // poe em modo supervisor, para que o acesso seja feito na memória física
+  // erro e complemento são copiados antes, porque poe_mem altera esses
+  //   registradores
+  err_t erro = self->erro;
+  int complemento = self->complemento;
   self->modo = supervisor;
   poe_mem(self, IRQ_END_PC,          self->PC);
   poe_mem(self, IRQ_END_A,           self->A);
   poe_mem(self, IRQ_END_X,           self->X);
-  poe_mem(self, IRQ_END_erro,        self->erro);
-  poe_mem(self, IRQ_END_complemento, self->complemento);
+  poe_mem(self, IRQ_END_erro,        erro);
+  poe_mem(self, IRQ_END_complemento, complemento);
   poe_mem(self, IRQ_END_modo,        usuario);
 
   self->A = irq;
   self->erro = ERR_OK;
   self->PC = 10;
+  self->n_interrupcoes[irq]++;
 
   return true;
 }
 
 static void cpu_desinterrompe(cpu_t *self)
 {
-  int dado;
+  // o registrador de erro é recuperado por último, porque pega_mem altera
+  //   esse registrador
+  int dado, erro;
   pega_mem(self, IRQ_END_PC,          &self->PC);
   pega_mem(self, IRQ_END_A,           &self->A);
   pega_mem(self, IRQ_END_X,           &self->X);
-  pega_mem(self, IRQ_END_erro,        &dado);
-  self->erro = dado;
+  pega_mem(self, IRQ_END_erro,        &erro);
   pega_mem(self, IRQ_END_complemento, &self->complemento);
   pega_mem(self, IRQ_END_modo,        &dado);
   self->modo = dado;
+  self->erro = erro;
 }
 
 void cpu_define_chamaC(cpu_t *self, func_chamaC_t funcaoC, void *argC)
@@ -469,3 +504,69 @@ void cpu_define_chamaC(cpu_t *self, func_chamaC_t funcaoC, void *argC)
   self->argC = argC;
 }
 
+int cpu_pc(cpu_t *self)
+{
+  return self->PC;
+}
+
+cpu_modo_t cpu_modo(cpu_t *self)
+{
+  return self->modo;
+}
+
+err_t cpu_erro(cpu_t *self)
+{
+  return self->erro;
+}
+
+long cpu_n_instrucoes(cpu_t *self, int opcode)
+{
+  if (opcode < 0 || opcode >= N_OPCODE) return self->n_instrucoes;
+  return self->n_opcode[opcode];
+}
+
+long cpu_n_interrupcoes(cpu_t *self, irq_t irq)
+{
+  if (irq >= 0 && irq < N_IRQ) return self->n_interrupcoes[irq];
+  long total = 0;
+  for (int i = 0; i < N_IRQ; i++) {
+    total += self->n_interrupcoes[i];
+  }
+  return total;
+}
+
+void cpu_define_perfil(cpu_t *self, perfil_t *perfil)
+{
+  self->perfil = perfil;
+}
+
+// ---------------------------------------------------------------------
+// métricas
+
+// o id da métrica é o número da interrupção, ou -1 para as instruções
+#define MET_INSTRUCOES -1
+
+static long cpu_le_metrica(void *fonte, int id)
+{
+  cpu_t *self = fonte;
+  if (id == MET_INSTRUCOES) return self->n_instrucoes;
+  return self->n_interrupcoes[id];
+}
+
+void cpu_registra_metricas(cpu_t *self, metricas_t *met)
+{
+  met_registra(met, "cpu_instrucoes_total", NULL,
+               "Instruções executadas sem erro", MET_CONTADOR,
+               self, MET_INSTRUCOES, cpu_le_metrica);
+  met_registra(met, "cpu_instrucoes_por_segundo", NULL,
+               "Instruções executadas por segundo do hospedeiro", MET_TAXA,
+               self, MET_INSTRUCOES, cpu_le_metrica);
+  for (int irq = 0; irq < N_IRQ; irq++) {
+    char rotulo[100];
+    snprintf(rotulo, sizeof(rotulo), "irq=\"%s\"", irq_nome(irq));
+    met_registra(met, "cpu_interrupcoes_total", rotulo,
+                 "Interrupções aceitas pela CPU", MET_CONTADOR,
+                 self, irq, cpu_le_metrica);
+  }
+}
+
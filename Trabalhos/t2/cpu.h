@@ -13,6 +13,8 @@
 #include "mmu.h"
 #include "es.h"
 #include "irq.h"
+#include "metricas.h"
+#include "perfil.h"
 
 typedef struct cpu_t cpu_t; // tipo opaco
 
@@ -44,4 +46,26 @@ void cpu_define_chamaC(cpu_t *self, func_chamaC_t func, void *argC);
 // retorna uma string (estática), com o estado da CPU
 char *cpu_descricao(cpu_t *self);
 
+// retornam o PC, o modo de execução e o estado de erro da CPU, para quem
+//   observa a execução
+int cpu_pc(cpu_t *self);
+cpu_modo_t cpu_modo(cpu_t *self);
+err_t cpu_erro(cpu_t *self);
+
+// retorna o número de instruções executadas sem erro desde a criação da
+//   CPU, com o opcode 'opcode' (ou todas, se for -1)
+long cpu_n_instrucoes(cpu_t *self, int opcode);
+
+// retorna o número de interrupções do tipo 'irq' aceitas desde a criação
+//   da CPU (ou de todos os tipos, se for -1)
+long cpu_n_interrupcoes(cpu_t *self, irq_t irq);
+
+// define o perfil onde são contadas as instruções executadas (NULL para
+//   não contar)
+void cpu_define_perfil(cpu_t *self, perfil_t *perfil);
+
+// registra as métricas da CPU: instruções executadas (e por segundo) e
+//   interrupções aceitas, por tipo
+void cpu_registra_metricas(cpu_t *self, metricas_t *met);
+
 #endif // CPU_H
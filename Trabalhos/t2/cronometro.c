@@ -0,0 +1,158 @@
+#include "cronometro.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CRONO_TSC
+#endif
+
+// maior aninhamento de trechos medido; os mais internos são ignorados
+#define CRONO_MAX_ANINHAMENTO 16
+
+static char *nome_subsistema[CRONO_N_SUBSISTEMAS] = {
+  [CRONO_CPU] = "cpu",
+  [CRONO_MMU] = "mmu",
+  [CRONO_ES] = "es",
+  [CRONO_CONSOLE] = "console",
+  [CRONO_SO] = "so",
+};
+
+// os tempos são em unidades do contador (ciclos com o rdtsc, ns sem)
+static struct {
+  bool iniciado;
+  uint64_t t_inicio;
+  int64_t ns_inicio;
+  uint64_t total[CRONO_N_SUBSISTEMAS];
+  uint64_t proprio[CRONO_N_SUBSISTEMAS];
+  long n_entradas[CRONO_N_SUBSISTEMAS];
+  // os trechos abertos
+  struct {
+    crono_subsistema_t s;
+    uint64_t t_entrada;
+    uint64_t t_aninhados;   // tempo dos trechos aninhados neste
+  } trechos[CRONO_MAX_ANINHAMENTO];
+  int n_trechos;
+} crono = { .iniciado = false };
+
+static int64_t ns_hospedeiro(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static inline uint64_t agora(void)
+{
+#ifdef CRONO_TSC
+  return __rdtsc();
+#else
+  return ns_hospedeiro();
+#endif
+}
+
+// ns por unidade do contador, calculado desde o início
+static double ns_por_unidade(void)
+{
+#ifdef CRONO_TSC
+  uint64_t t = agora();
+  int64_t ns = ns_hospedeiro() - crono.ns_inicio;
+  if (t == crono.t_inicio) return 0.0;
+  return (double)ns / (t - crono.t_inicio);
+#else
+  return 1.0;
+#endif
+}
+
+void crono_inicia(void)
+{
+  crono.ns_inicio = ns_hospedeiro();
+  crono.t_inicio = agora();
+  crono.n_trechos = 0;
+  crono.iniciado = true;
+}
+
+void crono_entra(crono_subsistema_t s)
+{
+  if (!crono.iniciado) return;
+  if (crono.n_trechos < CRONO_MAX_ANINHAMENTO) {
+    crono.trechos[crono.n_trechos].s = s;
+    crono.trechos[crono.n_trechos].t_aninhados = 0;
+    crono.trechos[crono.n_trechos].t_entrada = agora();
+  }
+  crono.n_trechos++;
+}
+
+void crono_sai(crono_subsistema_t s)
+{
+  if (!crono.iniciado) return;
+  uint64_t t = agora();
+  crono.n_trechos--;
+  if (crono.n_trechos >= CRONO_MAX_ANINHAMENTO) return;
+  uint64_t dt = t - crono.trechos[crono.n_trechos].t_entrada;
+  crono.total[s] += dt;
+  crono.proprio[s] += dt - crono.trechos[crono.n_trechos].t_aninhados;
+  crono.n_entradas[s]++;
+  if (crono.n_trechos > 0) {
+    crono.trechos[crono.n_trechos - 1].t_aninhados += dt;
+  }
+}
+
+
+// métricas
+
+// o id é o subsistema vezes 2, mais 0 para o tempo próprio (em ns) e 1
+//   para o número de entradas
+static long crono_le_metrica(void *fonte, int id)
+{
+  crono_subsistema_t s = id / 2;
+  if (id % 2 == 1) return crono.n_entradas[s];
+  return crono.proprio[s] * ns_por_unidade();
+}
+
+void crono_registra_metricas(metricas_t *met)
+{
+  for (int s = 0; s < CRONO_N_SUBSISTEMAS; s++) {
+    char rotulo[40];
+    snprintf(rotulo, sizeof(rotulo), "subsistema=\"%s\"", nome_subsistema[s]);
+    met_registra(met, "simulador_tempo_proprio_ns_total", rotulo,
+                 "Tempo do hospedeiro gasto no subsistema, sem os aninhados",
+                 MET_CONTADOR, NULL, 2 * s, crono_le_metrica);
+  }
+  for (int s = 0; s < CRONO_N_SUBSISTEMAS; s++) {
+    char rotulo[40];
+    snprintf(rotulo, sizeof(rotulo), "subsistema=\"%s\"", nome_subsistema[s]);
+    met_registra(met, "simulador_entradas_total", rotulo,
+                 "Trechos medidos do subsistema", MET_CONTADOR,
+                 NULL, 2 * s + 1, crono_le_metrica);
+  }
+}
+
+
+// relatório
+
+void crono_imprime(FILE *arq)
+{
+  if (!crono.iniciado) return;
+  double ns = ns_por_unidade();
+  double t_execucao = (ns_hospedeiro() - crono.ns_inicio) / 1e9;
+  if (t_execucao <= 0) t_execucao = 1e-9;
+  fprintf(arq, "cronômetro: %.3f s de execução\n", t_execucao);
+  fprintf(arq, "  %-10s %12s %10s %10s %6s %10s\n", "subsistema",
+          "entradas", "total (s)", "próprio (s)", "%", "ns/entrada");
+  double t_medido = 0;
+  for (int s = 0; s < CRONO_N_SUBSISTEMAS; s++) {
+    double total = crono.total[s] * ns / 1e9;
+    double proprio = crono.proprio[s] * ns / 1e9;
+    long n = crono.n_entradas[s];
+    t_medido += proprio;
+    fprintf(arq, "  %-10s %12ld %10.3f %10.3f %5.1f%% %10.1f\n",
+            nome_subsistema[s], n, total, proprio,
+            100 * proprio / t_execucao, n == 0 ? 0.0 : proprio * 1e9 / n);
+  }
+  double resto = t_execucao - t_medido;
+  fprintf(arq, "  %-10s %12s %10s %10.3f %5.1f%%\n", "(resto)", "", "",
+          resto, 100 * resto / t_execucao);
+}
@@ -0,0 +1,65 @@
+#ifndef CRONOMETRO_H
+#define CRONOMETRO_H
+
+// cronômetro do simulador
+// mede o tempo do hospedeiro gasto em cada subsistema do simulador (o
+//   interpretador da CPU, a MMU, os dispositivos de E/S, o desenho da
+//   console e o tratamento das interrupções pelo SO), para saber onde
+//   vale a pena otimizar
+// cada trecho medido é delimitado por CRONO_ENTRA e CRONO_SAI; os trechos
+//   podem ser aninhados (o SO é chamado pela CPU, que chama a MMU), e o
+//   tempo de cada subsistema é contado de duas formas: o total, desde a
+//   entrada até a saída, e o próprio, descontado o tempo dos trechos
+//   aninhados nele
+// no final, CRONO_TERMINA imprime a divisão do tempo da execução; o que
+//   não está em nenhum trecho é do laço do controlador e dos relógios
+// os tempos são medidos com o contador de ciclos do processador (rdtsc),
+//   convertido para ns pela comparação com clock_gettime no intervalo
+//   todo; em outras arquiteturas, com clock_gettime em cada medida
+// só é compilado se CRONOMETRO estiver definido (ver Makefile); senão as
+//   macros abaixo não geram código; mesmo com o rdtsc, a medida de cada
+//   instrução da CPU custa algumas dezenas de ns
+// como o simulador tem uma só thread, o cronômetro é global
+
+#include <stdio.h>
+#include "metricas.h"
+
+typedef enum {
+  CRONO_CPU,        // cpu_executa_1
+  CRONO_MMU,        // mmu_le, mmu_escreve
+  CRONO_ES,         // es_le, es_escreve (as funções dos dispositivos)
+  CRONO_CONSOLE,    // console_atualiza
+  CRONO_SO,         // so_trata_interrupcao
+  CRONO_N_SUBSISTEMAS
+} crono_subsistema_t;
+
+// começa a medir; o tempo total da execução é contado a partir daqui
+void crono_inicia(void);
+
+// entra e sai de um trecho do subsistema 's'
+// os trechos devem ser fechados na ordem inversa da abertura
+void crono_entra(crono_subsistema_t s);
+void crono_sai(crono_subsistema_t s);
+
+// registra as métricas do cronômetro: tempo próprio e número de entradas
+//   de cada subsistema
+void crono_registra_metricas(metricas_t *met);
+
+// imprime a divisão do tempo em 'arq'
+void crono_imprime(FILE *arq);
+
+#ifdef CRONOMETRO
+#define CRONO_INICIA() crono_inicia()
+#define CRONO_ENTRA(s) crono_entra(s)
+#define CRONO_SAI(s) crono_sai(s)
+#define CRONO_REGISTRA_METRICAS(met) crono_registra_metricas(met)
+#define CRONO_TERMINA() crono_imprime(stderr)
+#else
+#define CRONO_INICIA() ((void)0)
+#define CRONO_ENTRA(s) ((void)0)
+#define CRONO_SAI(s) ((void)0)
+#define CRONO_REGISTRA_METRICAS(met) ((void)0)
+#define CRONO_TERMINA() ((void)0)
+#endif
+
+#endif // CRONOMETRO_H
@@ -1,6 +1,8 @@
 #include "es.h"
+#include "cronometro.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // estrutura para definir um dispositivo
 typedef struct {
@@ -10,29 +12,58 @@ typedef struct {
    int id;              // identificador do (sub)dispositivo (arg das f acima)
 } dispositivo_t;
 
-#define N_DISPO 100 // número máximo de dispositivos suportados
+#define N_DISPO_INI 100 // número inicial de dispositivos suportados
 
 // define a estrutura opaca
+// o vetor de dispositivos cresce quando é registrado um dispositivo que
+//   não cabe nele
 struct es_t {
-  dispositivo_t dispositivos[N_DISPO];
+  dispositivo_t *dispositivos;
+  int n_dispositivos;
 };
 
 es_t *es_cria(void)
 {
-  es_t *self = calloc(1, sizeof(*self)); // com calloc já zera toda a struct
+  es_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  // com calloc já zera todos os dispositivos
+  self->dispositivos = calloc(N_DISPO_INI, sizeof(dispositivo_t));
+  if (self->dispositivos == NULL) {
+    free(self);
+    return NULL;
+  }
+  self->n_dispositivos = N_DISPO_INI;
   return self;
 }
 
 void es_destroi(es_t *self)
 {
+  free(self->dispositivos);
   free(self);
 }
 
+// aumenta o vetor de dispositivos para caber o dispositivo 'dispositivo'
+static bool es_aumenta(es_t *self, int dispositivo)
+{
+  int n = self->n_dispositivos * 2;
+  if (n <= dispositivo) n = dispositivo + 1;
+  dispositivo_t *d = realloc(self->dispositivos, n * sizeof(dispositivo_t));
+  if (d == NULL) return false;
+  memset(&d[self->n_dispositivos], 0,
+         (n - self->n_dispositivos) * sizeof(dispositivo_t));
+  self->dispositivos = d;
+  self->n_dispositivos = n;
+  return true;
+}
+
 bool es_registra_dispositivo(es_t *self, int dispositivo,
                              void *controladora, int id,
                              f_le_t f_le, f_escr_t f_escr)
 {
-  if (dispositivo < 0 || dispositivo >= N_DISPO) return false;
+  if (dispositivo < 0) return false;
+  if (dispositivo >= self->n_dispositivos && !es_aumenta(self, dispositivo)) {
+    return false;
+  }
   self->dispositivos[dispositivo].controladora = controladora;
   self->dispositivos[dispositivo].id = id;
   self->dispositivos[dispositivo].f_le = f_le;
@@ -40,20 +71,46 @@ bool es_registra_dispositivo(es_t *self, int dispositivo,
   return true;
 }
 
+int es_aloca_dispositivo(es_t *self, void *controladora, int id,
+                         f_le_t f_le, f_escr_t f_escr)
+{
+  int dispositivo = 0;
+  while (dispositivo < self->n_dispositivos
+         && (self->dispositivos[dispositivo].f_le != NULL
+             || self->dispositivos[dispositivo].f_escr != NULL)) {
+    dispositivo++;
+  }
+  if (!es_registra_dispositivo(self, dispositivo, controladora, id,
+                               f_le, f_escr)) {
+    return -1;
+  }
+  return dispositivo;
+}
+
 err_t es_le(es_t *self, int dispositivo, int *pvalor)
 {
-  if (dispositivo < 0 || dispositivo >= N_DISPO) return ERR_DISP_INV;
+  if (dispositivo < 0 || dispositivo >= self->n_dispositivos) {
+    return ERR_DISP_INV;
+  }
   if (self->dispositivos[dispositivo].f_le == NULL) return ERR_OP_INV;
   void *controladora = self->dispositivos[dispositivo].controladora;
   int id = self->dispositivos[dispositivo].id;
-  return self->dispositivos[dispositivo].f_le(controladora, id, pvalor);
+  CRONO_ENTRA(CRONO_ES);
+  err_t err = self->dispositivos[dispositivo].f_le(controladora, id, pvalor);
+  CRONO_SAI(CRONO_ES);
+  return err;
 }
 
 err_t es_escreve(es_t *self, int dispositivo, int valor)
 {
-  if (dispositivo < 0 || dispositivo >= N_DISPO) return ERR_DISP_INV;
+  if (dispositivo < 0 || dispositivo >= self->n_dispositivos) {
+    return ERR_DISP_INV;
+  }
   if (self->dispositivos[dispositivo].f_escr == NULL) return ERR_OP_INV;
   void *controladora = self->dispositivos[dispositivo].controladora;
   int id = self->dispositivos[dispositivo].id;
-  return self->dispositivos[dispositivo].f_escr(controladora, id, valor);
+  CRONO_ENTRA(CRONO_ES);
+  err_t err = self->dispositivos[dispositivo].f_escr(controladora, id, valor);
+  CRONO_SAI(CRONO_ES);
+  return err;
 }
@@ -35,6 +35,13 @@ bool es_registra_dispositivo(es_t *self, int dispositivo,
                              void *controladora, int id,
                              f_le_t f_le, f_escr_t f_escr);
 
+// registra um dispositivo como es_registra_dispositivo, com a menor
+//   identificação que ainda não está em uso
+// retorna a identificação do dispositivo, ou -1 se não foi possível
+//   registrar
+int es_aloca_dispositivo(es_t *self, void *controladora, int id,
+                         f_le_t f_le, f_escr_t f_escr);
+
 // lê um inteiro de um dispositivo
 // retorna ERR_OK se bem sucedido, ou
 //   ERR_DISP_INV se dispositivo desconhecido
@@ -0,0 +1,490 @@
+#include "escalonador.h"
+#include <stdlib.h>
+#include <limits.h>
+
+// quantum da política circular, em interrupções de relógio
+#define QUANTUM_CIRCULAR 5
+
+// número de níveis da MLFQ, e quantum de cada nível
+// p3 (muita E/S) bloqueia antes de esgotar o quantum e fica nos níveis
+//   altos; p1 (muita CPU) desce para o último nível, onde executa por mais
+//   tempo a cada vez, com menos trocas de processo
+#define N_NIVEIS 3
+static const int quantum_nivel[N_NIVEIS] = { 2, 4, 8 };
+
+// intervalo entre os reforços de prioridade da MLFQ, em interrupções de
+//   relógio
+#define PERIODO_REFORCO 100
+
+// latência do CFS, em interrupções de relógio: o período em que todos os
+//   processos prontos devem executar uma vez
+#define LATENCIA_CFS 12
+// diferença de tempo virtual (em unidades de relógio) a partir da qual um
+//   processo pronto toma o lugar do que está executando; é também o
+//   máximo de crédito que um processo que estava bloqueado pode ter
+#define GRANULARIDADE_CFS 100
+
+// peso de cada valor de nice no CFS (o de nice 0 é 1024); cada nível de
+//   nice corresponde a ~10% de tempo de CPU
+static const int peso_nice[NICE_MAX - NICE_MIN + 1] = {
+  /* -20 */ 88761, 71755, 56483, 46273, 36291,
+  /* -15 */ 29154, 23254, 18705, 14949, 11916,
+  /* -10 */  9548,  7620,  6100,  4904,  3906,
+  /*  -5 */  3121,  2501,  1991,  1586,  1277,
+  /*   0 */  1024,   820,   655,   526,   423,
+  /*   5 */   335,   272,   215,   172,   137,
+  /*  10 */   110,    87,    70,    56,    45,
+  /*  15 */    36,    29,    23,    18,    15,
+};
+#define PESO_NICE_0 1024
+
+// limite de utilização para o RMS com n processos (n(2^(1/n) - 1), o
+//   teste de Liu e Layland); para mais processos, usa o limite assintótico
+//   (ln 2)
+#define N_LIMITE_RMS 10
+static const double limite_rms[N_LIMITE_RMS] = {
+  1.0, 0.8284, 0.7798, 0.7568, 0.7435, 0.7348, 0.7286, 0.7241, 0.7205, 0.7177
+};
+#define LIMITE_RMS_ASSINTOTICO 0.6931
+
+struct escalonador_t {
+  esc_politica_t politica;
+  esc_tempo_real_t tempo_real;
+  // uma fila por nível; aponta para o primeiro processo, o último é o
+  //   anterior a ele
+  // a política circular só usa a primeira
+  processo_t *fila[N_NIVEIS];
+  // interrupções de relógio desde o último reforço
+  int tics;
+  // número de reforços já realizados
+  // o processo cuja época é diferente desta não foi atingido pelo último
+  //   reforço, seu nível deve ser considerado 0
+  int epoca;
+  // raiz do heap de processos prontos do CFS, ordenado por tempo virtual
+  processo_t *heap;
+  // menor tempo virtual já escolhido (nunca diminui)
+  long min_vruntime;
+  // número de processos prontos, e soma dos seus pesos
+  int n_prontos;
+  long soma_pesos;
+  // heap de processos de tempo real prontos, na ordem do algoritmo
+  processo_t *heap_tr;
+  // processos admitidos na classe de tempo real, e sua utilização total
+  int n_tr;
+  double utilizacao_tr;
+};
+
+escalonador_t *esc_cria(esc_politica_t politica, esc_tempo_real_t tempo_real)
+{
+  if (politica < 0 || politica >= N_ESC) return NULL;
+  if (tempo_real < 0 || tempo_real >= N_ESC_TR) return NULL;
+  escalonador_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->politica = politica;
+  self->tempo_real = tempo_real;
+  for (int nivel = 0; nivel < N_NIVEIS; nivel++) {
+    self->fila[nivel] = NULL;
+  }
+  self->tics = 0;
+  self->epoca = 0;
+  self->heap = NULL;
+  self->min_vruntime = 0;
+  self->n_prontos = 0;
+  self->soma_pesos = 0;
+  self->heap_tr = NULL;
+  self->n_tr = 0;
+  self->utilizacao_tr = 0;
+  return self;
+}
+
+void esc_destroi(escalonador_t *self)
+{
+  free(self);
+}
+
+
+// operações nas filas circulares
+
+static void fila_insere(processo_t **fila, processo_t *proc)
+{
+  if (*fila == NULL) {
+    proc->ant = proc;
+    proc->prox = proc;
+    *fila = proc;
+    return;
+  }
+  // o último da fila é o anterior ao primeiro
+  processo_t *ultimo = (*fila)->ant;
+  proc->ant = ultimo;
+  proc->prox = *fila;
+  ultimo->prox = proc;
+  (*fila)->ant = proc;
+}
+
+static void fila_remove(processo_t **fila, processo_t *proc)
+{
+  if (proc->prox == proc) {
+    *fila = NULL;
+  } else {
+    proc->ant->prox = proc->prox;
+    proc->prox->ant = proc->ant;
+    if (*fila == proc) *fila = proc->prox;
+  }
+  proc->ant = NULL;
+  proc->prox = NULL;
+}
+
+// coloca todos os processos da fila 'origem' no final da fila 'destino'
+static void fila_junta(processo_t **destino, processo_t **origem)
+{
+  if (*origem == NULL) return;
+  if (*destino != NULL) {
+    processo_t *ultimo_destino = (*destino)->ant;
+    processo_t *ultimo_origem = (*origem)->ant;
+    ultimo_destino->prox = *origem;
+    (*origem)->ant = ultimo_destino;
+    ultimo_origem->prox = *destino;
+    (*destino)->ant = ultimo_origem;
+  } else {
+    *destino = *origem;
+  }
+  *origem = NULL;
+}
+
+
+// operações no heap de pareamento
+// a ordem do heap é dada por uma função que diz se um processo deve
+//   executar antes de outro
+
+typedef bool (*antes_t)(escalonador_t *self, processo_t *a, processo_t *b);
+
+// ordem do CFS: menor tempo virtual
+static bool antes_cfs(escalonador_t *self, processo_t *a, processo_t *b)
+{
+  if (a->vruntime != b->vruntime) return a->vruntime < b->vruntime;
+  return a->pid < b->pid;
+}
+
+// o prazo relativo que conta para o RMS e para o teste de admissão: um
+//   prazo maior que o período é tratado como igual ao período
+static int prazo_efetivo(int periodo, int prazo)
+{
+  return prazo < periodo ? prazo : periodo;
+}
+
+// ordem dos processos de tempo real: prazo mais cedo (EDF) ou menor
+//   prazo relativo (RMS, que com prazo igual ao período é o menor período)
+static bool antes_tr(escalonador_t *self, processo_t *a, processo_t *b)
+{
+  if (self->tempo_real == ESC_TR_EDF) {
+    if (a->prazo_abs != b->prazo_abs) return a->prazo_abs < b->prazo_abs;
+  } else {
+    int pa = prazo_efetivo(a->periodo, a->prazo);
+    int pb = prazo_efetivo(b->periodo, b->prazo);
+    if (pa != pb) return pa < pb;
+  }
+  return a->pid < b->pid;
+}
+
+// une dois heaps (cujas raízes não têm irmãos), retorna a raiz do resultado
+static processo_t *heap_une(escalonador_t *self, antes_t antes,
+                            processo_t *a, processo_t *b)
+{
+  if (a == NULL) return b;
+  if (b == NULL) return a;
+  if (antes(self, b, a)) {
+    processo_t *t = a;
+    a = b;
+    b = t;
+  }
+  // b passa a ser o primeiro filho de a
+  b->prox = a->filho;
+  if (a->filho != NULL) a->filho->ant = b;
+  b->ant = a;
+  a->filho = b;
+  return a;
+}
+
+// une uma lista de irmãos em um só heap, em duas passadas: une os pares
+//   da esquerda para a direita, e depois os resultados da direita para
+//   a esquerda
+static processo_t *heap_une_irmaos(escalonador_t *self, antes_t antes,
+                                   processo_t *primeiro)
+{
+  // os resultados da primeira passada ficam em uma pilha, encadeada
+  //   por 'prox'
+  processo_t *pares = NULL;
+  while (primeiro != NULL) {
+    processo_t *a = primeiro;
+    processo_t *b = a->prox;
+    primeiro = b == NULL ? NULL : b->prox;
+    a->ant = a->prox = NULL;
+    if (b != NULL) b->ant = b->prox = NULL;
+    processo_t *par = heap_une(self, antes, a, b);
+    par->prox = pares;
+    pares = par;
+  }
+  processo_t *raiz = NULL;
+  while (pares != NULL) {
+    processo_t *par = pares;
+    pares = par->prox;
+    par->prox = NULL;
+    raiz = heap_une(self, antes, raiz, par);
+  }
+  return raiz;
+}
+
+static void heap_insere(escalonador_t *self, antes_t antes,
+                        processo_t **heap, processo_t *proc)
+{
+  proc->ant = proc->prox = proc->filho = NULL;
+  *heap = heap_une(self, antes, *heap, proc);
+}
+
+static void heap_remove(escalonador_t *self, antes_t antes,
+                        processo_t **heap, processo_t *proc)
+{
+  processo_t *filhos = heap_une_irmaos(self, antes, proc->filho);
+  if (proc == *heap) {
+    *heap = filhos;
+  } else {
+    // tira o processo da lista de irmãos (ou de filhos do pai)
+    if (proc->ant->filho == proc) {
+      proc->ant->filho = proc->prox;
+    } else {
+      proc->ant->prox = proc->prox;
+    }
+    if (proc->prox != NULL) proc->prox->ant = proc->ant;
+    *heap = heap_une(self, antes, *heap, filhos);
+  }
+  proc->ant = proc->prox = proc->filho = NULL;
+}
+
+
+// níveis
+
+// atualiza o nível do processo, se ele não estiver em dia com o último
+//   reforço
+static void atualiza_nivel(escalonador_t *self, processo_t *proc)
+{
+  if (proc->epoca != self->epoca) {
+    proc->nivel = 0;
+    proc->epoca = self->epoca;
+  }
+}
+
+// todos os processos voltam para o nível mais alto
+// os que estão nas filas são movidos agora; os demais (bloqueados ou em
+//   execução) quando forem atualizados
+static void reforca(escalonador_t *self)
+{
+  for (int nivel = 1; nivel < N_NIVEIS; nivel++) {
+    fila_junta(&self->fila[0], &self->fila[nivel]);
+  }
+  self->epoca++;
+}
+
+
+static int peso(processo_t *proc)
+{
+  return peso_nice[proc->nice - NICE_MIN];
+}
+
+void esc_insere(escalonador_t *self, processo_t *proc)
+{
+  if (proc->pronto_no_esc) return;
+  proc->pronto_no_esc = true;
+  self->n_prontos++;
+  self->soma_pesos += peso(proc);
+  if (proc->tempo_real) {
+    heap_insere(self, antes_tr, &self->heap_tr, proc);
+    return;
+  }
+  if (self->politica == ESC_CFS) {
+    // um processo que ficou bloqueado (ou é novo) não pode acumular
+    //   crédito demais em relação aos que estavam executando
+    long min = self->min_vruntime - GRANULARIDADE_CFS;
+    if (proc->vruntime < min) proc->vruntime = min;
+    heap_insere(self, antes_cfs, &self->heap, proc);
+    return;
+  }
+  atualiza_nivel(self, proc);
+  fila_insere(&self->fila[proc->nivel], proc);
+}
+
+void esc_remove(escalonador_t *self, processo_t *proc)
+{
+  if (!proc->pronto_no_esc) return;
+  proc->pronto_no_esc = false;
+  self->n_prontos--;
+  self->soma_pesos -= peso(proc);
+  if (proc->tempo_real) {
+    heap_remove(self, antes_tr, &self->heap_tr, proc);
+    return;
+  }
+  if (self->politica == ESC_CFS) {
+    heap_remove(self, antes_cfs, &self->heap, proc);
+    return;
+  }
+  atualiza_nivel(self, proc);
+  fila_remove(&self->fila[proc->nivel], proc);
+}
+
+processo_t *esc_proximo(escalonador_t *self)
+{
+  if (self->heap_tr != NULL) {
+    processo_t *proc = self->heap_tr;
+    esc_remove(self, proc);
+    return proc;
+  }
+  if (self->politica == ESC_CFS) {
+    processo_t *proc = self->heap;
+    if (proc != NULL) {
+      esc_remove(self, proc);
+      if (proc->vruntime > self->min_vruntime) {
+        self->min_vruntime = proc->vruntime;
+      }
+    }
+    return proc;
+  }
+  for (int nivel = 0; nivel < N_NIVEIS; nivel++) {
+    processo_t *proc = self->fila[nivel];
+    if (proc != NULL) {
+      esc_remove(self, proc);
+      return proc;
+    }
+  }
+  return NULL;
+}
+
+bool esc_vazio(escalonador_t *self)
+{
+  return self->n_prontos == 0;
+}
+
+bool esc_tem_mais_prioritario(escalonador_t *self, processo_t *proc)
+{
+  // processo de tempo real tira qualquer outro da CPU
+  if (self->heap_tr != NULL) {
+    if (!proc->tempo_real) return true;
+    return antes_tr(self, self->heap_tr, proc);
+  }
+  if (proc->tempo_real) return false;
+  if (self->politica == ESC_CFS) {
+    return self->heap != NULL
+           && self->heap->vruntime + GRANULARIDADE_CFS < proc->vruntime;
+  }
+  if (self->politica != ESC_MLFQ) return false;
+  atualiza_nivel(self, proc);
+  for (int nivel = 0; nivel < proc->nivel; nivel++) {
+    if (self->fila[nivel] != NULL) return true;
+  }
+  return false;
+}
+
+int esc_quantum(escalonador_t *self, processo_t *proc)
+{
+  // processo de tempo real não tem quantum
+  if (proc->tempo_real) return INT_MAX;
+  if (self->politica == ESC_CIRCULAR) return QUANTUM_CIRCULAR;
+  if (self->politica == ESC_CFS) {
+    // a parte da latência proporcional ao peso do processo entre os
+    //   prontos (ele não está entre eles, está sendo escolhido)
+    long quantum = LATENCIA_CFS * peso(proc) / (self->soma_pesos + peso(proc));
+    return quantum < 1 ? 1 : quantum;
+  }
+  atualiza_nivel(self, proc);
+  return quantum_nivel[proc->nivel];
+}
+
+void esc_fim_quantum(escalonador_t *self, processo_t *proc)
+{
+  if (self->politica != ESC_MLFQ || proc->tempo_real) return;
+  atualiza_nivel(self, proc);
+  if (proc->nivel < N_NIVEIS - 1) proc->nivel++;
+}
+
+void esc_executou(escalonador_t *self, processo_t *proc, int tempo)
+{
+  if (self->politica != ESC_CFS || proc->tempo_real) return;
+  proc->vruntime += (long)tempo * PESO_NICE_0 / peso(proc);
+}
+
+void esc_bloqueou(escalonador_t *self, processo_t *proc)
+{
+  if (self->politica != ESC_MLFQ || proc->tempo_real) return;
+  atualiza_nivel(self, proc);
+  if (proc->nivel > 0) proc->nivel--;
+}
+
+void esc_tictac(escalonador_t *self)
+{
+  if (self->politica != ESC_MLFQ) return;
+  self->tics++;
+  if (self->tics >= PERIODO_REFORCO) {
+    self->tics = 0;
+    reforca(self);
+  }
+}
+
+// utilização da CPU pelo processo de tempo real, para o teste de admissão
+// com prazo menor que o período, usa a densidade (wcet / prazo), nas duas
+//   políticas: no RMS é como se o período fosse o prazo, o que torna o
+//   limite de utilização suficiente também com a ordem por prazo
+static double utilizacao(int periodo, int wcet, int prazo)
+{
+  return (double)wcet / prazo_efetivo(periodo, prazo);
+}
+
+bool esc_admite_tempo_real(escalonador_t *self, processo_t *proc,
+                           int periodo, int wcet, int prazo)
+{
+  if (proc->tempo_real) return false;
+  if (periodo <= 0 || wcet <= 0 || prazo <= 0) return false;
+  // um processo que pode executar por mais tempo que o prazo nunca tem
+  //   garantia de cumpri-lo
+  if (wcet > prazo) return false;
+  double u = self->utilizacao_tr + utilizacao(periodo, wcet, prazo);
+  double limite;
+  if (self->tempo_real == ESC_TR_EDF) {
+    limite = 1.0;
+  } else if (self->n_tr < N_LIMITE_RMS) {
+    limite = limite_rms[self->n_tr];
+  } else {
+    limite = LIMITE_RMS_ASSINTOTICO;
+  }
+  if (u > limite) return false;
+  self->utilizacao_tr = u;
+  self->n_tr++;
+  proc->periodo = periodo;
+  proc->wcet = wcet;
+  proc->prazo = prazo;
+  proc->tempo_real = true;
+  return true;
+}
+
+void esc_libera_tempo_real(escalonador_t *self, processo_t *proc)
+{
+  if (!proc->tempo_real) return;
+  self->utilizacao_tr -= utilizacao(proc->periodo, proc->wcet, proc->prazo);
+  self->n_tr--;
+}
+
+char *esc_nome_tempo_real(escalonador_t *self)
+{
+  static char *nomes[N_ESC_TR] = {
+    [ESC_TR_EDF] = "EDF",
+    [ESC_TR_RMS] = "RMS",
+  };
+  return nomes[self->tempo_real];
+}
+
+char *esc_nome(escalonador_t *self)
+{
+  static char *nomes[N_ESC] = {
+    [ESC_CIRCULAR] = "circular",
+    [ESC_MLFQ]     = "MLFQ",
+    [ESC_CFS]      = "CFS",
+  };
+  return nomes[self->politica];
+}
@@ -0,0 +1,116 @@
+#ifndef ESCALONADOR_H
+#define ESCALONADOR_H
+
+// escalonador de processos
+// mantém os processos prontos, e escolhe qual deve ser o próximo a executar
+// os processos são mantidos em filas (circulares), encadeadas pelos
+//   campos 'ant' e 'prox' dos descritores, de forma que inserir, remover
+//   e escolher um processo são operações de tempo constante, ou em um heap
+//   de pareamento, em que inserir é constante e remover e escolher são
+//   O(log n) (amortizado)
+// tem três políticas:
+// - circular (round-robin): uma só fila, todos com o mesmo quantum
+// - filas multinível com realimentação (MLFQ): uma fila por nível de
+//   prioridade, com quantum maior nos níveis de menor prioridade; o processo
+//   que esgota o quantum desce um nível, o que bloqueia sobe um nível, e
+//   periodicamente todos voltam para o nível mais alto, para que os
+//   processos dos níveis mais baixos não morram de fome
+// - completamente justa (CFS): cada processo acumula um tempo virtual de
+//   execução, que cresce mais devagar quanto menor o seu 'nice'; executa
+//   sempre o processo pronto com menor tempo virtual, e o quantum é uma
+//   fração de uma latência fixa, proporcional ao peso do processo
+// acima dessas políticas, tem a classe de tempo real: os processos
+//   periódicos admitidos nessa classe são escolhidos antes de todos os
+//   outros, por prazo mais cedo (EDF) ou por menor prazo relativo (RMS,
+//   na variante "deadline monotonic", que com prazos iguais aos períodos
+//   é a ordem por menor período), e não têm quantum (executam até
+//   bloquear ou até chegar um processo de tempo real mais prioritário); um
+//   processo só é admitido na classe se a utilização total da CPU pelos
+//   processos de tempo real continuar garantindo que todos cumprem seus
+//   prazos
+
+#include "processo.h"
+#include <stdbool.h>
+
+typedef enum {
+  ESC_CIRCULAR,
+  ESC_MLFQ,
+  ESC_CFS,
+  N_ESC
+} esc_politica_t;
+
+// algoritmo da classe de tempo real
+typedef enum {
+  ESC_TR_EDF,   // earliest deadline first
+  ESC_TR_RMS,   // rate (deadline) monotonic
+  N_ESC_TR
+} esc_tempo_real_t;
+
+// limites para o valor de nice de um processo
+#define NICE_MIN -20
+#define NICE_MAX  19
+
+typedef struct escalonador_t escalonador_t;
+
+// cria um escalonador com a política e o algoritmo de tempo real, sem
+//   processos
+// retorna NULL em caso de erro
+escalonador_t *esc_cria(esc_politica_t politica, esc_tempo_real_t tempo_real);
+
+// destrói o escalonador (não destrói os processos)
+void esc_destroi(escalonador_t *self);
+
+// insere um processo pronto no final da fila do seu nível
+void esc_insere(escalonador_t *self, processo_t *proc);
+
+// remove um processo da fila, esteja onde estiver
+void esc_remove(escalonador_t *self, processo_t *proc);
+
+// retira e retorna o processo que deve executar a seguir (o primeiro da
+//   fila de maior prioridade que não está vazia), ou NULL se não tiver
+//   processo pronto
+processo_t *esc_proximo(escalonador_t *self);
+
+// retorna true se não tiver nenhum processo pronto
+bool esc_vazio(escalonador_t *self);
+
+// retorna true se tiver um processo pronto com prioridade maior que a do
+//   processo (que está executando), e que por isso deve tomar o lugar dele
+bool esc_tem_mais_prioritario(escalonador_t *self, processo_t *proc);
+
+// retorna o quantum (em interrupções de relógio) que o processo deve
+//   receber quando for escolhido para executar
+int esc_quantum(escalonador_t *self, processo_t *proc);
+
+// informa que o processo esgotou seu quantum (antes de ser reinserido)
+void esc_fim_quantum(escalonador_t *self, processo_t *proc);
+
+// informa que o processo executou por 'tempo' unidades de relógio
+void esc_executou(escalonador_t *self, processo_t *proc, int tempo);
+
+// informa que o processo bloqueou
+void esc_bloqueou(escalonador_t *self, processo_t *proc);
+
+// informa que houve uma interrupção de relógio
+void esc_tictac(escalonador_t *self);
+
+// verifica se o processo pode ser admitido na classe de tempo real, com
+//   o período, wcet e prazo informados (teste de utilização; o wcet não
+//   pode ser maior que o prazo); se puder, contabiliza a utilização dele,
+//   coloca os parâmetros no descritor, marca ele como de tempo real e
+//   retorna true
+// se não puder (ou se ele já for de tempo real), o descritor não é alterado
+// o processo deve ser o que está em execução
+bool esc_admite_tempo_real(escalonador_t *self, processo_t *proc,
+                           int periodo, int wcet, int prazo);
+
+// retira da classe de tempo real o processo (que está terminando)
+void esc_libera_tempo_real(escalonador_t *self, processo_t *proc);
+
+// retorna o nome do algoritmo de tempo real
+char *esc_nome_tempo_real(escalonador_t *self);
+
+// retorna o nome da política
+char *esc_nome(escalonador_t *self);
+
+#endif // ESCALONADOR_H
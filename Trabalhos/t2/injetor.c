@@ -0,0 +1,122 @@
+#include "injetor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// um evento: um comando a executar em um momento
+typedef struct {
+  long momento;
+  int ordem;         // posição no roteiro, para desempate
+  char *comando;
+} evento_t;
+
+struct injetor_t {
+  console_t *console;
+  evento_t *eventos;
+  int n_eventos;
+  int proximo;       // índice do próximo evento a executar
+};
+
+// compara eventos para a ordenação, pelo momento e pela ordem no roteiro
+static int compara_eventos(const void *a, const void *b)
+{
+  const evento_t *ea = a, *eb = b;
+  if (ea->momento != eb->momento) return ea->momento < eb->momento ? -1 : 1;
+  return ea->ordem - eb->ordem;
+}
+
+// interpreta uma linha do roteiro, e acrescenta o evento correspondente
+//   (se tiver) no injetor
+// 'momento' é o momento do evento anterior, e é alterado para o deste
+// retorna false se a linha for inválida
+static bool pega_evento(injetor_t *self, char *lin, long *momento)
+{
+  lin[strcspn(lin, "\n")] = '\0';
+  int pos;
+  char c;
+  if (sscanf(lin, " %c", &c) != 1 || c == '#') return true;
+  bool relativo = c == '+';
+  long valor;
+  if (sscanf(lin, " %*[+]%ld %n", &valor, &pos) != 1
+      && sscanf(lin, " %ld %n", &valor, &pos) != 1) {
+    return false;
+  }
+  if (valor < 0 || lin[pos] == '\0') return false;
+  *momento = relativo ? *momento + valor : valor;
+  evento_t *ev = realloc(self->eventos, (self->n_eventos + 1) * sizeof(*ev));
+  if (ev == NULL) return false;
+  self->eventos = ev;
+  ev = &self->eventos[self->n_eventos];
+  ev->momento = *momento;
+  ev->ordem = self->n_eventos;
+  ev->comando = strdup(lin + pos);
+  if (ev->comando == NULL) return false;
+  self->n_eventos++;
+  return true;
+}
+
+injetor_t *inj_cria(console_t *console, char *nome)
+{
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) return NULL;
+  injetor_t *self = malloc(sizeof(*self));
+  if (self == NULL) {
+    fclose(arq);
+    return NULL;
+  }
+  self->console = console;
+  self->eventos = NULL;
+  self->n_eventos = 0;
+  self->proximo = 0;
+  char *linha = NULL;
+  size_t tam_lin;
+  long momento = 0;
+  int n_lin = 0;
+  while (getline(&linha, &tam_lin, arq) != -1) {
+    n_lin++;
+    if (!pega_evento(self, linha, &momento)) {
+      console_printf(console, "roteiro '%s': linha %d inválida", nome, n_lin);
+      inj_destroi(self);
+      self = NULL;
+      break;
+    }
+  }
+  free(linha);
+  fclose(arq);
+  if (self != NULL) {
+    qsort(self->eventos, self->n_eventos, sizeof(evento_t), compara_eventos);
+  }
+  return self;
+}
+
+void inj_destroi(injetor_t *self)
+{
+  for (int i = 0; i < self->n_eventos; i++) {
+    free(self->eventos[i].comando);
+  }
+  free(self->eventos);
+  free(self);
+}
+
+void inj_executa(injetor_t *self, long agora)
+{
+  while (self->proximo < self->n_eventos
+         && self->eventos[self->proximo].momento <= agora) {
+    console_executa_comando(self->console,
+                            self->eventos[self->proximo].comando);
+    self->proximo++;
+  }
+}
+
+bool inj_tem_eventos(injetor_t *self)
+{
+  return self->proximo < self->n_eventos;
+}
+
+bool inj_proximo(injetor_t *self, long *pmomento)
+{
+  if (self->proximo >= self->n_eventos) return false;
+  *pmomento = self->eventos[self->proximo].momento;
+  return true;
+}
@@ -0,0 +1,41 @@
+#ifndef INJETOR_H
+#define INJETOR_H
+
+// injetor de eventos
+// executa comandos da console (como se fossem digitados pelo operador) em
+//   momentos determinados da simulação, lidos de um arquivo de roteiro
+// cada linha do roteiro tem o momento, em unidades do relógio, e o comando
+//   (ver console.c); o momento pode ser relativo ao da linha anterior, se
+//   começar com '+'; linhas vazias ou começando com '#' são ignoradas
+// ex:
+//   # digita 42 e enter no terminal b no instante 1200, e termina 500
+//   #   unidades depois
+//   1200 Db42\n
+//   +500 F
+// os eventos são ordenados pelo momento (os de mesmo momento ficam na
+//   ordem do roteiro); a cada unidade de tempo só é comparado o momento
+//   atual com o do próximo evento
+
+#include "console.h"
+
+typedef struct injetor_t injetor_t;
+
+// cria um injetor com os eventos do arquivo 'nome', que vão ser executados
+//   na console
+// retorna NULL em caso de erro (arquivo inexistente ou linha inválida)
+injetor_t *inj_cria(console_t *console, char *nome);
+
+// destrói o injetor
+void inj_destroi(injetor_t *self);
+
+// executa os eventos cujo momento é 'agora' ou anterior
+void inj_executa(injetor_t *self, long agora);
+
+// retorna true se ainda tem eventos a executar
+bool inj_tem_eventos(injetor_t *self);
+
+// retorna true se ainda tem eventos a executar, e coloca em *pmomento o
+//   momento do próximo
+bool inj_proximo(injetor_t *self, long *pmomento);
+
+#endif // INJETOR_H
@@ -7,6 +7,9 @@ static char *nomes[N_IRQ] = {
   [IRQ_RELOGIO] = "E/S: relógio",
   [IRQ_TECLADO] = "E/S: teclado",
   [IRQ_TELA]    = "E/S: console",
+  [IRQ_RELOGIO_1] = "E/S: relógio 1",
+  [IRQ_RELOGIO_2] = "E/S: relógio 2",
+  [IRQ_RELOGIO_3] = "E/S: relógio 3",
 };
 
 // retorna o nome da interrupção
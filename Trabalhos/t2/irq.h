@@ -11,6 +11,10 @@ typedef enum {
   IRQ_RELOGIO,       // interrupção causada pelo relógio
   IRQ_TECLADO,       // interrupção causada pelo teclado
   IRQ_TELA,          // interrupção causada pela tela
+  // os demais canais do relógio (o canal 0 usa IRQ_RELOGIO)
+  IRQ_RELOGIO_1,
+  IRQ_RELOGIO_2,
+  IRQ_RELOGIO_3,
   N_IRQ              // número de interrupções
 } irq_t;
 
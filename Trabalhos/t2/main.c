@@ -6,36 +6,210 @@
 #include "relogio.h"
 #include "console.h"
 #include "so.h"
+#include "rastro.h"
+#include "cronometro.h"
+#include "contadores.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 // constantes
 #define MEM_TAM 10000        // tamanho da memória principal
+// tamanho da memória secundária (1G valores)
+// só ocupa memória do hospedeiro na parte efetivamente usada
+#define MEM_SEC_TAM (1 << 30)
+// número de terminais da console, se não for informado na execução
+#define N_TERMINAIS 4
+// configuração dos terminais: capacidade das filas de entrada e de saída,
+//   velocidade da saída (tics por caractere) e número de caracteres na
+//   fila de saída em que é pedida interrupção
+#define TERM_TAM_ENTRADA  32
+#define TERM_TAM_SAIDA    16
+#define TERM_TICS_POR_CAR  4
+#define TERM_LIMIAR_SAIDA  4
+// arquivo do rastro de eventos, se estiver compilado (ver rastro.h)
+#define ARQ_RASTRO "rastro.bin"
+// período do amostrador, em unidades de tempo (primo, para não acompanhar
+//   o período do relógio e dos lotes do controle)
+#define PERIODO_AMOSTRAS 997
 
 
 typedef struct {
   mem_t *mem;
+  mem_t *mem_sec;
   mmu_t *mmu;
   cpu_t *cpu;
   relogio_t *relogio;
   console_t *console;
   es_t *es;
+  contadores_t *contadores;
   controle_t *controle;
+  injetor_t *injetor;
 } hardware_t;
 
-void cria_hardware(hardware_t *hw)
+// configuração da execução, obtida dos argumentos da linha de comando
+// uso: main [-s] [-r roteiro] [-m métricas] [-p perfil] [-a amostras]
+//            [-n terminais] [-t terminais=ligação]...
+//   -s    sem tela: a console não usa a tela nem o teclado, e a simulação
+//         começa executando (ver console_cria); o fim deve vir do roteiro
+//   -r    executa os comandos do arquivo de roteiro (ver injetor.h)
+//   -m    exporta métricas para o arquivo ou socket (unix:caminho)
+//         indicado (ver metricas.h)
+//   -p    conta as instruções executadas, e grava o relatório no arquivo
+//         indicado (ver perfil.h)
+//   -a    amostra a execução periodicamente, e grava as pilhas de chamadas
+//         amostradas no arquivo indicado, no formato do flamegraph (ver
+//         amostrador.h)
+//   -n    número de terminais
+//   -t    liga terminais (ver console_liga_terminal); 'terminais' é o
+//         número de um terminal (o primeiro é 0) ou um intervalo, como
+//         4-99; 'ligação' é um de
+//           curses
+//           nulo
+//           pty
+//           arquivo:entrada:saída
+//           roteiro:entrada:saída
+//         onde 'entrada' e 'saída' são nomes de arquivos do hospedeiro
+//         (vazio se não tiver), em que %d é trocado pelo número do terminal
+typedef struct {
+  bool com_tela;
+  char *roteiro;
+  char *metricas;
+  char *perfil;
+  char *amostras;
+  int n_terminais;
+  char **ligacoes;
+  int n_ligacoes;
+} config_t;
+
+bool pega_config(config_t *cfg, int argc, char *argv[])
+{
+  cfg->com_tela = true;
+  cfg->roteiro = NULL;
+  cfg->metricas = NULL;
+  cfg->perfil = NULL;
+  cfg->amostras = NULL;
+  cfg->n_terminais = N_TERMINAIS;
+  cfg->ligacoes = malloc(argc * sizeof(char *));
+  cfg->n_ligacoes = 0;
+  if (cfg->ligacoes == NULL) return false;
+  int opt;
+  while ((opt = getopt(argc, argv, "sr:m:p:a:n:t:")) != -1) {
+    switch (opt) {
+      case 's':
+        cfg->com_tela = false;
+        break;
+      case 'r':
+        cfg->roteiro = optarg;
+        break;
+      case 'm':
+        cfg->metricas = optarg;
+        break;
+      case 'p':
+        cfg->perfil = optarg;
+        break;
+      case 'a':
+        cfg->amostras = optarg;
+        break;
+      case 'n':
+        cfg->n_terminais = atoi(optarg);
+        if (cfg->n_terminais < 1) return false;
+        break;
+      case 't':
+        cfg->ligacoes[cfg->n_ligacoes++] = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+  return optind == argc;
+}
+
+// coloca em 'nome' o nome de arquivo 'modelo', com %d trocado por 't'
+// um modelo vazio (ou NULL) corresponde a não ter arquivo (NULL)
+static char *nome_do_terminal(int tam, char nome[tam], char *modelo, int t)
+{
+  if (modelo == NULL || *modelo == '\0') return NULL;
+  char *p = strstr(modelo, "%d");
+  if (p == NULL) {
+    snprintf(nome, tam, "%s", modelo);
+  } else {
+    snprintf(nome, tam, "%.*s%d%s", (int)(p - modelo), modelo, t, p + 2);
+  }
+  return nome;
+}
+
+// liga os terminais conforme a descrição 'desc' ("terminais=ligação")
+static bool liga_terminais(console_t *console, char *desc)
+{
+  int prim, ult, pos = -1;
+  if (sscanf(desc, "%d-%d=%n", &prim, &ult, &pos) != 2 || pos == -1) {
+    pos = -1;
+    if (sscanf(desc, "%d=%n", &prim, &pos) != 1 || pos == -1) return false;
+    ult = prim;
+  }
+  // separa os campos da ligação
+  char lig[strlen(desc) + 1];
+  strcpy(lig, desc + pos);
+  char *campo[3] = { lig, NULL, NULL };
+  for (int c = 1; c < 3; c++) {
+    char *p = strchr(campo[c - 1], ':');
+    if (p == NULL) break;
+    *p = '\0';
+    campo[c] = p + 1;
+  }
+  static struct { char *nome; term_backend_t backend; } tipos[] = {
+    { "curses",  TERM_CURSES  },
+    { "nulo",    TERM_NULO    },
+    { "arquivo", TERM_ARQUIVO },
+    { "pty",     TERM_PTY     },
+    { "roteiro", TERM_ROTEIRO },
+  };
+  int tipo;
+  for (tipo = 0; tipo < sizeof(tipos) / sizeof(tipos[0]); tipo++) {
+    if (strcmp(tipos[tipo].nome, campo[0]) == 0) break;
+  }
+  if (tipo == sizeof(tipos) / sizeof(tipos[0])) return false;
+  for (int t = prim; t <= ult; t++) {
+    char entrada[FILENAME_MAX], saida[FILENAME_MAX];
+    if (!console_liga_terminal(console, t, tipos[tipo].backend,
+            nome_do_terminal(sizeof(entrada), entrada, campo[1], t),
+            nome_do_terminal(sizeof(saida), saida, campo[2], t))) {
+      console_printf(console, "não foi possível ligar o terminal %d", t);
+      return false;
+    }
+  }
+  return true;
+}
+
+void cria_hardware(hardware_t *hw, config_t *cfg)
 {
   // cria a memória e a MMU
   hw->mem = mem_cria(MEM_TAM);
   hw->mmu = mmu_cria(hw->mem);
+  // cria a memória secundária (usada pelo SO para a paginação)
+  hw->mem_sec = mem_cria(MEM_SEC_TAM);
 
   // cria dispositivos de E/S
-  hw->console = console_cria();
+  hw->console = console_cria(cfg->n_terminais, cfg->com_tela);
+  for (int t = 0; t < cfg->n_terminais; t++) {
+    console_configura_terminal(hw->console, t, TERM_TAM_ENTRADA,
+                               TERM_TAM_SAIDA, TERM_TICS_POR_CAR,
+                               TERM_LIMIAR_SAIDA);
+  }
+  for (int l = 0; l < cfg->n_ligacoes; l++) {
+    if (!liga_terminais(hw->console, cfg->ligacoes[l])) {
+      console_printf(hw->console, "ligação inválida: '%s'", cfg->ligacoes[l]);
+    }
+  }
   hw->relogio = rel_cria();
 
   // cria o controlador de E/S e registra os dispositivos
   hw->es = es_cria();
+  // os terminais A e B, o relógio e os contadores de desempenho têm
+  //   identificações fixas, que são usadas diretamente pelos programas
   // lê teclado, testa teclado, escreve tela, testa tela do terminal A
   es_registra_dispositivo(hw->es, 0, hw->console, 0, term_le, NULL);
   es_registra_dispositivo(hw->es, 1, hw->console, 1, term_le, NULL);
@@ -46,44 +220,159 @@ void cria_hardware(hardware_t *hw)
   es_registra_dispositivo(hw->es, 5, hw->console, 5, term_le, NULL);
   es_registra_dispositivo(hw->es, 6, hw->console, 6, NULL, term_escr);
   es_registra_dispositivo(hw->es, 7, hw->console, 7, term_le, NULL);
-  // lê relógio virtual, relógio real
-  es_registra_dispositivo(hw->es, 8, hw->relogio, 0, rel_le, NULL);
-  es_registra_dispositivo(hw->es, 9, hw->relogio, 1, rel_le, NULL);
+  // lê relógio virtual, relógio real (a parte de baixo dos 64 bits), e as
+  //   partes de cima, guardadas na leitura das de baixo
+  es_registra_dispositivo(hw->es, 8, hw->relogio, REL_AGORA, rel_le, NULL);
+  es_registra_dispositivo(hw->es, 9, hw->relogio, REL_HOSPEDEIRO, rel_le,
+                          NULL);
+  es_registra_dispositivo(hw->es, 10, hw->relogio, REL_AGORA_ALTO, rel_le,
+                          NULL);
+  es_registra_dispositivo(hw->es, 11, hw->relogio, REL_HOSPEDEIRO_ALTO, rel_le,
+                          NULL);
 
   // cria a unidade de execução e inicializa com a MMU e E/S
   hw->cpu = cpu_cria(hw->mmu, hw->es);
 
+  // os contadores de desempenho leem a CPU e a MMU
+  // seleciona o contador, lê o valor selecionado (32 bits de baixo e de
+  //   cima), lê o estado ou executa um comando
+  hw->contadores = cont_cria(hw->cpu, hw->mmu);
+  if (hw->contadores != NULL) {
+    es_registra_dispositivo(hw->es, 12, hw->contadores, CONT_SELECAO,
+                            cont_le, cont_escr);
+    es_registra_dispositivo(hw->es, 13, hw->contadores, CONT_VALOR,
+                            cont_le, NULL);
+    es_registra_dispositivo(hw->es, 14, hw->contadores, CONT_VALOR_ALTO,
+                            cont_le, NULL);
+    es_registra_dispositivo(hw->es, 15, hw->contadores, CONT_COMANDO,
+                            cont_le, cont_escr);
+  }
+
+  // os dispositivos dos demais terminais recebem as próximas identificações
+  //   livres, na mesma ordem
+  for (int t = 2; t < cfg->n_terminais; t++) {
+    es_aloca_dispositivo(hw->es, hw->console, t * 4 + 0, term_le, NULL);
+    es_aloca_dispositivo(hw->es, hw->console, t * 4 + 1, term_le, NULL);
+    es_aloca_dispositivo(hw->es, hw->console, t * 4 + 2, NULL, term_escr);
+    es_aloca_dispositivo(hw->es, hw->console, t * 4 + 3, term_le, NULL);
+  }
+
   // cria o controlador e inicializa com a CPU
   hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio);
+
+  // cria o injetor dos eventos do roteiro
+  hw->injetor = NULL;
+  if (cfg->roteiro != NULL) {
+    hw->injetor = inj_cria(hw->console, cfg->roteiro);
+    if (hw->injetor == NULL) {
+      console_printf(hw->console, "erro no roteiro '%s'", cfg->roteiro);
+    }
+    controle_define_injetor(hw->controle, hw->injetor);
+  }
 }
 
 void destroi_hardware(hardware_t *hw)
 {
   controle_destroi(hw->controle);
+  if (hw->injetor != NULL) inj_destroi(hw->injetor);
+  if (hw->contadores != NULL) cont_destroi(hw->contadores);
   cpu_destroi(hw->cpu);
   es_destroi(hw->es);
   rel_destroi(hw->relogio);
   console_destroi(hw->console);
   mmu_destroi(hw->mmu);
+  mem_destroi(hw->mem_sec);
   mem_destroi(hw->mem);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
   hardware_t hw;
   so_t *so;
+  config_t cfg;
 
+  if (!pega_config(&cfg, argc, argv)) {
+    fprintf(stderr, "uso: %s [-s] [-r roteiro] [-m métricas] [-p perfil]"
+                    " [-a amostras] [-n terminais]"
+                    " [-t terminais=ligação]...\n", argv[0]);
+    return 1;
+  }
+  CRONO_INICIA();
   // cria o hardware
-  cria_hardware(&hw);
+  cria_hardware(&hw, &cfg);
+  if (!RASTRO_INICIA(ARQ_RASTRO)) {
+    console_printf(hw.console, "erro no rastro '%s'", ARQ_RASTRO);
+  }
   // cria o sistema operacional
-  so = so_cria(hw.cpu, hw.mem, hw.mmu, hw.console, hw.relogio);
-  
+  so = so_cria(hw.cpu, hw.mem, hw.mem_sec, hw.mmu, hw.console, hw.relogio);
+  so_define_contadores(so, hw.contadores);
+
+  // cria o exportador de métricas, com as métricas de cada componente
+  metricas_t *met = NULL;
+  if (cfg.metricas != NULL) {
+    met = met_cria(cfg.metricas);
+    if (met == NULL) {
+      console_printf(hw.console, "erro nas métricas '%s'", cfg.metricas);
+    } else {
+      cpu_registra_metricas(hw.cpu, met);
+      mmu_registra_metricas(hw.mmu, met);
+      so_registra_metricas(so, met);
+      CRONO_REGISTRA_METRICAS(met);
+      controle_define_metricas(hw.controle, met);
+    }
+  }
+
+  // cria o perfil de execução
+  perfil_t *perfil = NULL;
+  if (cfg.perfil != NULL) {
+    perfil = perfil_cria();
+    cpu_define_perfil(hw.cpu, perfil);
+    so_define_perfil(so, perfil);
+  }
+
+  // cria o amostrador
+  amostrador_t *amo = NULL;
+  if (cfg.amostras != NULL) {
+    amo = amo_cria(hw.cpu, hw.mmu, PERIODO_AMOSTRAS);
+    if (amo == NULL) {
+      console_printf(hw.console, "erro no amostrador");
+    } else {
+      so_define_amostrador(so, amo);
+      controle_define_amostrador(hw.controle, amo);
+    }
+  }
+
   // executa o laço de execução da CPU
   controle_laco(hw.controle);
 
-  // destroi tudo
+  if (perfil != NULL) {
+    if (!perfil_grava_relatorio(perfil, cfg.perfil)) {
+      console_printf(hw.console, "erro na gravação do perfil '%s'",
+                     cfg.perfil);
+    }
+    cpu_define_perfil(hw.cpu, NULL);
+    so_define_perfil(so, NULL);
+    perfil_destroi(perfil);
+  }
+
+  if (amo != NULL) {
+    if (!amo_grava(amo, cfg.amostras)) {
+      console_printf(hw.console, "erro na gravação das amostras '%s'",
+                     cfg.amostras);
+    }
+    so_define_amostrador(so, NULL);
+    controle_define_amostrador(hw.controle, NULL);
+    amo_destroi(amo);
+  }
+
+  // destroi tudo (as métricas antes, porque leem os outros componentes)
+  if (met != NULL) met_destroi(met);
   so_destroi(so);
   destroi_hardware(&hw);
+  RASTRO_TERMINA();
+  // depois de destruir a console, para não misturar com a tela
+  CRONO_TERMINA();
+  free(cfg.ligacoes);
   return 0;
 }
 
@@ -0,0 +1,49 @@
+#ifndef MAQB_H
+#define MAQB_H
+
+// formato binário de programa executável (arquivos '.mqb')
+// alternativa ao formato textual '.maq', gerada pelo montador, para ser
+//   mapeada em memória e usada diretamente na carga de programas, sem
+//   necessidade de interpretar o conteúdo do arquivo
+//
+// o arquivo é formado por uma sequência de palavras de 32 bits, em
+//   little-endian:
+//   - um cabeçalho (maqb_cabecalho_t)
+//   - a tabela de segmentos, com n_segmentos entradas (maqb_segmento_t)
+//   - os dados dos segmentos, cada um no deslocamento informado na tabela
+// os deslocamentos são em palavras, a partir do início do arquivo
+// segmentos do tipo MAQB_SEG_ZERO (regiões reservadas com ESPACO) não têm
+//   dados no arquivo, só endereço e tamanho; devem ser carregados com 0
+// as posições do programa que não pertencem a nenhum segmento também valem 0
+
+#include <stdint.h>
+
+#define MAQB_MAGICO 0x4251414d  // "MAQB" em little-endian
+#define MAQB_VERSAO 2
+
+typedef struct {
+  int32_t magico;       // MAQB_MAGICO
+  int32_t versao;       // MAQB_VERSAO
+  int32_t tamanho;      // número de posições de memória do programa
+  int32_t carga;        // endereço inicial de carga
+  int32_t inicio;       // endereço inicial de execução
+  int32_t n_segmentos;  // número de entradas na tabela de segmentos
+} maqb_cabecalho_t;
+
+// tipos de segmento
+#define MAQB_SEG_DADOS 0  // segmento com dados no arquivo
+#define MAQB_SEG_ZERO  1  // segmento sem dados, inicializado com 0
+
+typedef struct {
+  int32_t tipo;         // MAQB_SEG_DADOS ou MAQB_SEG_ZERO
+  int32_t endereco;     // endereço de carga do segmento
+  int32_t tamanho;      // número de palavras do segmento
+  int32_t deslocamento; // posição dos dados do segmento no arquivo (só
+                        //   para MAQB_SEG_DADOS)
+} maqb_segmento_t;
+
+// número de palavras do cabeçalho e de cada entrada da tabela de segmentos
+#define MAQB_TAM_CABECALHO (sizeof(maqb_cabecalho_t) / sizeof(int32_t))
+#define MAQB_TAM_SEGMENTO  (sizeof(maqb_segmento_t) / sizeof(int32_t))
+
+#endif // MAQB_H
@@ -1,20 +1,31 @@
 #include "memoria.h"
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 // tipo de dados opaco para representar uma região de memória
+// o conteúdo é mapeado com mmap, sem reserva: o sistema hospedeiro só
+//   aloca uma página quando ela é acessada pela primeira vez (e a página
+//   inicia zerada)
 struct mem_t {
   int tam;
   int *conteudo;
+  size_t tam_mapa;  // tamanho do mapeamento, em bytes
 };
 
 mem_t *mem_cria(int tam)
 {
   mem_t *self;
+  if (tam <= 0) return NULL;
   self = malloc(sizeof(*self));
   if (self != NULL) {
     self->tam = tam;
-    self->conteudo = malloc(tam * sizeof(*(self->conteudo)));
-    if (self->conteudo == NULL) {
+    self->tam_mapa = (size_t)tam * sizeof(*(self->conteudo));
+    self->conteudo = mmap(NULL, self->tam_mapa, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (self->conteudo == MAP_FAILED) {
       free(self);
       self = NULL;
     }
@@ -25,9 +36,7 @@ mem_t *mem_cria(int tam)
 void mem_destroi(mem_t *self)
 {
   if (self != NULL) {
-    if (self->conteudo != NULL) {
-      free(self->conteudo);
-    }
+    munmap(self->conteudo, self->tam_mapa);
     free(self);
   }
 }
@@ -63,3 +72,85 @@ err_t mem_escreve(mem_t *self, int endereco, int valor)
   }
   return err;
 }
+
+// função auxiliar, verifica se todos os endereços de um bloco são válidos
+static err_t verif_bloco(mem_t *self, int endereco, int tam)
+{
+  if (endereco < 0 || tam < 0 || endereco > self->tam - tam) {
+    return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+err_t mem_le_bloco(mem_t *self, int endereco, int tam, int valores[tam])
+{
+  err_t err = verif_bloco(self, endereco, tam);
+  if (err == ERR_OK) {
+    memcpy(valores, &self->conteudo[endereco], tam * sizeof(int));
+  }
+  return err;
+}
+
+err_t mem_copia_bloco(mem_t *self, int endereco, int tam,
+                      const int valores[tam])
+{
+  err_t err = verif_bloco(self, endereco, tam);
+  if (err == ERR_OK) {
+    memcpy(&self->conteudo[endereco], valores, tam * sizeof(int));
+  }
+  return err;
+}
+
+err_t mem_preenche_bloco(mem_t *self, int endereco, int tam, int valor)
+{
+  err_t err = verif_bloco(self, endereco, tam);
+  if (err != ERR_OK) return err;
+  int *p = &self->conteudo[endereco];
+  if (valor == 0) {
+    memset(p, 0, tam * sizeof(int));
+  } else {
+    // laço simples, o compilador vetoriza
+    for (int i = 0; i < tam; i++) {
+      p[i] = valor;
+    }
+  }
+  return ERR_OK;
+}
+
+err_t mem_copia_entre(mem_t *destino, int end_destino,
+                      mem_t *origem, int end_origem, int tam)
+{
+  err_t err = verif_bloco(destino, end_destino, tam);
+  if (err == ERR_OK) err = verif_bloco(origem, end_origem, tam);
+  if (err == ERR_OK) {
+    // memmove, porque pode ser a mesma memória, com blocos sobrepostos
+    memmove(&destino->conteudo[end_destino], &origem->conteudo[end_origem],
+            tam * sizeof(int));
+  }
+  return err;
+}
+
+err_t mem_descarta_bloco(mem_t *self, int endereco, int tam)
+{
+  err_t err = verif_bloco(self, endereco, tam);
+  if (err != ERR_OK) return err;
+  // só páginas inteiras do hospedeiro podem ser devolvidas; as partes nas
+  //   pontas do bloco são zeradas
+  uintptr_t tam_pag = sysconf(_SC_PAGESIZE);
+  uintptr_t ini = (uintptr_t)&self->conteudo[endereco];
+  uintptr_t fim = (uintptr_t)&self->conteudo[endereco + tam];
+  uintptr_t ini_pag = (ini + tam_pag - 1) & ~(tam_pag - 1);
+  uintptr_t fim_pag = fim & ~(tam_pag - 1);
+  if (ini_pag >= fim_pag) {
+    memset((void *)ini, 0, fim - ini);
+    return ERR_OK;
+  }
+  memset((void *)ini, 0, ini_pag - ini);
+  memset((void *)fim_pag, 0, fim - fim_pag);
+  // em um mapeamento anônimo privado, as páginas descartadas voltam zeradas
+  //   no próximo acesso
+  if (madvise((void *)ini_pag, fim_pag - ini_pag, MADV_DONTNEED) != 0) {
+    memset((void *)ini_pag, 0, fim_pag - ini_pag);
+  }
+  return ERR_OK;
+}
@@ -3,6 +3,10 @@
 
 // simulador da memória principal
 // é um vetor de inteiros
+// a memória do hospedeiro só é efetivamente ocupada quando uma região é
+//   acessada pela primeira vez, então é possível criar memórias muito
+//   grandes (para a memória secundária, por exemplo) sem pagar pelas
+//   regiões que não forem usadas
 
 #include "err.h"
 
@@ -10,6 +14,7 @@
 typedef struct mem_t mem_t;
 
 // cria uma região de memória com capacidade para 'tam' valores (inteiros)
+// o conteúdo inicial da memória é todo 0
 // retorna um ponteiro para um descritor, que deverá ser usado em todas
 //   as operações sobre essa memória
 // retorna NULL em caso de erro
@@ -30,4 +35,33 @@ err_t mem_le(mem_t *self, int endereco, int *pvalor);
 // retorna erro ERR_END_INV se endereço inválido
 err_t mem_escreve(mem_t *self, int endereco, int valor);
 
+// Funções de acesso a blocos de memória
+// O intervalo de endereços é verificado uma única vez; se alguma posição
+//   do bloco for inválida, retornam ERR_END_INV sem acessar a memória.
+// São mais eficientes que um laço de acessos individuais, para copiar
+//   páginas ou carregar programas.
+
+// coloca no vetor 'valores' os 'tam' valores a partir do endereço 'endereco'
+err_t mem_le_bloco(mem_t *self, int endereco, int tam, int valores[tam]);
+
+// copia os 'tam' valores do vetor 'valores' para a memória, a partir do
+//   endereço 'endereco'
+err_t mem_copia_bloco(mem_t *self, int endereco, int tam,
+                      const int valores[tam]);
+
+// coloca 'valor' nas 'tam' posições a partir do endereço 'endereco'
+err_t mem_preenche_bloco(mem_t *self, int endereco, int tam, int valor);
+
+// copia 'tam' valores da memória 'origem' a partir do endereço 'end_origem'
+//   para a memória 'destino' a partir do endereço 'end_destino'
+// as duas memórias podem ser a mesma, e os blocos podem se sobrepor
+err_t mem_copia_entre(mem_t *destino, int end_destino,
+                      mem_t *origem, int end_origem, int tam);
+
+// descarta o conteúdo das 'tam' posições a partir do endereço 'endereco',
+//   que passam a valer 0
+// a memória do hospedeiro ocupada pela região é devolvida ao sistema, até
+//   que ela seja acessada novamente
+err_t mem_descarta_bloco(mem_t *self, int endereco, int tam);
+
 #endif // MEMORIA_H
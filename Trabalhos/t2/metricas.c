@@ -0,0 +1,222 @@
+#include "metricas.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define PREFIXO_SOCKET "unix:"
+
+typedef struct {
+  char *nome;
+  char *rotulos;
+  char *ajuda;
+  met_tipo_t tipo;
+  void *fonte;
+  int id;
+  met_le_t f_le;
+  long anterior;     // valor na amostra anterior (para MET_TAXA)
+} metrica_t;
+
+struct metricas_t {
+  metrica_t *metricas;
+  int n_metricas;
+  int cap_metricas;
+  // destino: o arquivo (e o temporário onde é gravado antes), ou o socket
+  char *arquivo;
+  char *arquivo_tmp;
+  char *caminho_socket;
+  int socket;
+  // momentos (em ms do hospedeiro) da próxima exportação e da amostra
+  //   anterior
+  long prox_exportacao;
+  long t_anterior;
+};
+
+// tempo do hospedeiro, em milissegundos
+static long agora_ms(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000L + t.tv_nsec / 1000000;
+}
+
+static bool abre_socket(metricas_t *self, char *caminho)
+{
+  struct sockaddr_un end;
+  if (strlen(caminho) >= sizeof(end.sun_path)) return false;
+  self->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (self->socket < 0) return false;
+  memset(&end, 0, sizeof(end));
+  end.sun_family = AF_UNIX;
+  strcpy(end.sun_path, caminho);
+  // o socket de uma execução anterior fica no sistema de arquivos
+  unlink(caminho);
+  if (bind(self->socket, (struct sockaddr *)&end, sizeof(end)) < 0
+      || listen(self->socket, 4) < 0
+      || fcntl(self->socket, F_SETFL, O_NONBLOCK) < 0) {
+    close(self->socket);
+    self->socket = -1;
+    return false;
+  }
+  self->caminho_socket = strdup(caminho);
+  return self->caminho_socket != NULL;
+}
+
+metricas_t *met_cria(char *destino)
+{
+  metricas_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->metricas = NULL;
+  self->n_metricas = 0;
+  self->cap_metricas = 0;
+  self->arquivo = NULL;
+  self->arquivo_tmp = NULL;
+  self->caminho_socket = NULL;
+  self->socket = -1;
+  self->t_anterior = agora_ms();
+  self->prox_exportacao = self->t_anterior;
+  bool ok;
+  if (strncmp(destino, PREFIXO_SOCKET, strlen(PREFIXO_SOCKET)) == 0) {
+    ok = abre_socket(self, destino + strlen(PREFIXO_SOCKET));
+  } else {
+    self->arquivo = strdup(destino);
+    self->arquivo_tmp = malloc(strlen(destino) + 5);
+    ok = self->arquivo != NULL && self->arquivo_tmp != NULL;
+    if (ok) sprintf(self->arquivo_tmp, "%s.tmp", destino);
+  }
+  if (!ok) {
+    free(self->arquivo);
+    free(self->arquivo_tmp);
+    free(self);
+    return NULL;
+  }
+  return self;
+}
+
+static void met_grava_arquivo(metricas_t *self);
+
+void met_destroi(metricas_t *self)
+{
+  if (self->arquivo != NULL) met_grava_arquivo(self);
+  if (self->socket != -1) {
+    close(self->socket);
+    unlink(self->caminho_socket);
+  }
+  for (int i = 0; i < self->n_metricas; i++) {
+    free(self->metricas[i].nome);
+    free(self->metricas[i].rotulos);
+    free(self->metricas[i].ajuda);
+  }
+  free(self->metricas);
+  free(self->arquivo);
+  free(self->arquivo_tmp);
+  free(self->caminho_socket);
+  free(self);
+}
+
+bool met_registra(metricas_t *self, char *nome, char *rotulos, char *ajuda,
+                  met_tipo_t tipo, void *fonte, int id, met_le_t f_le)
+{
+  if (self->n_metricas == self->cap_metricas) {
+    int cap = self->cap_metricas == 0 ? 16 : 2 * self->cap_metricas;
+    metrica_t *m = realloc(self->metricas, cap * sizeof(metrica_t));
+    if (m == NULL) return false;
+    self->metricas = m;
+    self->cap_metricas = cap;
+  }
+  metrica_t *met = &self->metricas[self->n_metricas];
+  met->nome = strdup(nome);
+  met->rotulos = rotulos == NULL ? NULL : strdup(rotulos);
+  met->ajuda = strdup(ajuda);
+  if (met->nome == NULL || met->ajuda == NULL
+      || (rotulos != NULL && met->rotulos == NULL)) {
+    free(met->nome);
+    free(met->rotulos);
+    free(met->ajuda);
+    return false;
+  }
+  met->tipo = tipo;
+  met->fonte = fonte;
+  met->id = id;
+  met->f_le = f_le;
+  met->anterior = f_le(fonte, id);
+  self->n_metricas++;
+  return true;
+}
+
+// lê todas as métricas e grava a amostra em 'arq'
+static void met_amostra(metricas_t *self, FILE *arq)
+{
+  long agora = agora_ms();
+  long dt = agora - self->t_anterior;
+  char *nome_anterior = "";
+  for (int i = 0; i < self->n_metricas; i++) {
+    metrica_t *met = &self->metricas[i];
+    long valor = met->f_le(met->fonte, met->id);
+    if (strcmp(met->nome, nome_anterior) != 0) {
+      fprintf(arq, "# HELP %s %s\n", met->nome, met->ajuda);
+      fprintf(arq, "# TYPE %s %s\n", met->nome,
+              met->tipo == MET_CONTADOR ? "counter" : "gauge");
+      nome_anterior = met->nome;
+    }
+    fprintf(arq, "%s", met->nome);
+    if (met->rotulos != NULL) fprintf(arq, "{%s}", met->rotulos);
+    if (met->tipo == MET_TAXA) {
+      fprintf(arq, " %.1f\n",
+              dt <= 0 ? 0.0 : (valor - met->anterior) * 1000.0 / dt);
+    } else {
+      fprintf(arq, " %ld\n", valor);
+    }
+    met->anterior = valor;
+  }
+  self->t_anterior = agora;
+}
+
+static void met_grava_arquivo(metricas_t *self)
+{
+  FILE *arq = fopen(self->arquivo_tmp, "w");
+  if (arq == NULL) return;
+  met_amostra(self, arq);
+  if (fclose(arq) == 0) rename(self->arquivo_tmp, self->arquivo);
+}
+
+// responde cada conexão pendente no socket com uma amostra
+static void met_atende_conexoes(metricas_t *self)
+{
+  int cliente;
+  while ((cliente = accept(self->socket, NULL, NULL)) >= 0) {
+    char *texto;
+    size_t tam;
+    FILE *arq = open_memstream(&texto, &tam);
+    if (arq != NULL) {
+      met_amostra(self, arq);
+      fclose(arq);
+      for (size_t enviado = 0; enviado < tam; ) {
+        ssize_t n = send(cliente, texto + enviado, tam - enviado,
+                         MSG_NOSIGNAL);
+        if (n <= 0) break;
+        enviado += n;
+      }
+      free(texto);
+    }
+    close(cliente);
+  }
+}
+
+void met_atualiza(metricas_t *self)
+{
+  long agora = agora_ms();
+  if (agora < self->prox_exportacao) return;
+  if (self->arquivo != NULL) {
+    met_grava_arquivo(self);
+    self->prox_exportacao = agora + MET_PERIODO_ARQUIVO;
+  } else {
+    met_atende_conexoes(self);
+    self->prox_exportacao = agora + MET_PERIODO_SOCKET;
+  }
+}
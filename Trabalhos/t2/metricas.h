@@ -0,0 +1,60 @@
+#ifndef METRICAS_H
+#define METRICAS_H
+
+// métricas
+// exporta contadores do simulador no formato texto do Prometheus, para
+//   acompanhar execuções longas sem usar a tela
+// cada métrica é lida de uma fonte, por uma função registrada junto com
+//   ela (como os dispositivos de E/S, ver es.h); as leituras são feitas
+//   todas de uma vez, pelo laço do controlador, entre duas instruções,
+//   então os valores de uma amostra são coerentes entre si
+// o destino é um arquivo, reescrito periodicamente (a versão nova é
+//   gravada em outro arquivo e trocada de uma vez), ou um socket UNIX, que
+//   responde cada conexão com uma amostra e fecha a conexão
+//   (ex: socat - UNIX-CONNECT:caminho)
+
+#include <stdbool.h>
+
+// período de gravação do arquivo, e de atendimento das conexões do
+//   socket, em milissegundos do hospedeiro
+#define MET_PERIODO_ARQUIVO 1000
+#define MET_PERIODO_SOCKET    20
+
+typedef struct metricas_t metricas_t;
+
+// tipos de métrica
+//   MET_CONTADOR   valor que só cresce
+//   MET_MEDIDOR    valor que pode subir e descer
+//   MET_TAXA       lê um contador, e exporta (como medidor) quanto ele
+//                  cresceu por segundo do hospedeiro, desde a amostra
+//                  anterior
+typedef enum { MET_CONTADOR, MET_MEDIDOR, MET_TAXA } met_tipo_t;
+
+// função que lê o valor da métrica 'id' da fonte 'fonte' (os valores
+//   fornecidos no registro da métrica)
+typedef long (*met_le_t)(void *fonte, int id);
+
+// cria o exportador de métricas para 'destino': "unix:caminho" para um
+//   socket UNIX, ou o nome do arquivo
+// retorna NULL em caso de erro
+metricas_t *met_cria(char *destino);
+
+// destrói o exportador; se o destino for um arquivo, grava uma última
+//   amostra antes
+// as fontes das métricas ainda devem existir
+void met_destroi(metricas_t *self);
+
+// registra a métrica 'nome', com os rótulos 'rotulos' (no formato do
+//   Prometheus, como 'irq="relógio"', ou NULL se não tiver), descrita por
+//   'ajuda'; várias métricas com o mesmo nome e rótulos diferentes devem
+//   ser registradas em seguida, com o mesmo tipo
+// as strings são copiadas
+// retorna false se não foi possível registrar
+bool met_registra(metricas_t *self, char *nome, char *rotulos, char *ajuda,
+                  met_tipo_t tipo, void *fonte, int id, met_le_t f_le);
+
+// exporta uma amostra, se for a hora (ver MET_PERIODO_*)
+// deve ser chamada frequentemente pelo laço da simulação
+void met_atualiza(metricas_t *self);
+
+#endif // METRICAS_H
@@ -1,10 +1,14 @@
 #include "mmu.h"
+#include "cronometro.h"
 #include <stdlib.h>
 
 // tipo de dados opaco para representar uma MMU
 struct mmu_t {
   mem_t *mem;
   tabpag_t *tabpag;
+  // contadores, para as métricas
+  long n_traducoes;
+  long n_ausentes;      // traduções que falharam por página ausente
 };
 
 mmu_t *mmu_cria(mem_t *mem)
@@ -14,6 +18,8 @@ mmu_t *mmu_cria(mem_t *mem)
   if (self != NULL) {
     self->mem = mem;
     self->tabpag = NULL;
+    self->n_traducoes = 0;
+    self->n_ausentes = 0;
   }
   return self;
 }
@@ -30,34 +36,137 @@ void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag)
   self->tabpag = tabpag;
 }
 
+// traduz o endereço pela tabela de páginas, contando a tradução
+static err_t mmu_traduz(mmu_t *self, int endvirt, int *pendfis)
+{
+  err_t err = tabpag_traduz(self->tabpag, endvirt, pendfis);
+  self->n_traducoes++;
+  if (err == ERR_PAG_AUSENTE) self->n_ausentes++;
+  return err;
+}
+
 err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
 {
+  CRONO_ENTRA(CRONO_MMU);
+  err_t err;
   if (modo == supervisor || self->tabpag == NULL) {
+    err = mem_le(self->mem, endvirt, pvalor);
+  } else {
+    int endfis;
+    err = mmu_traduz(self, endvirt, &endfis);
+    if (err == ERR_OK) {
+      err = mem_le(self->mem, endfis, pvalor);
+      if (err == ERR_OK) {
+        tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, false);
+      }
+    }
+  }
+  CRONO_SAI(CRONO_MMU);
+  return err;
+}
+
+err_t mmu_consulta(mmu_t *self, int endvirt, int *pvalor)
+{
+  if (self->tabpag == NULL) {
     return mem_le(self->mem, endvirt, pvalor);
   }
   int endfis;
   err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
   if (err == ERR_OK) {
     err = mem_le(self->mem, endfis, pvalor);
+  }
+  return err;
+}
+
+err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
+{
+  CRONO_ENTRA(CRONO_MMU);
+  err_t err;
+  if (modo == supervisor || self->tabpag == NULL) {
+    err = mem_escreve(self->mem, endvirt, valor);
+  } else {
+    int endfis;
+    err = mmu_traduz(self, endvirt, &endfis);
     if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, false);
+      err = mem_escreve(self->mem, endfis, valor);
+      if (err == ERR_OK) {
+        tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, true);
+      }
     }
   }
+  CRONO_SAI(CRONO_MMU);
   return err;
 }
 
-err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
+err_t mmu_le_bloco(mmu_t *self, int endvirt, int tam, int valores[tam],
+                   cpu_modo_t modo)
 {
   if (modo == supervisor || self->tabpag == NULL) {
-    return mem_escreve(self->mem, endvirt, valor);
+    return mem_le_bloco(self->mem, endvirt, tam, valores);
   }
-  int endfis;
-  err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
-  if (err == ERR_OK) {
-    err = mem_escreve(self->mem, endfis, valor);
+  if (endvirt < 0) return ERR_END_INV;
+  while (tam > 0) {
+    // copia até o final da página ou do bloco
+    int n = TAM_PAGINA - endvirt % TAM_PAGINA;
+    if (n > tam) n = tam;
+    // as cópias em bloco são feitas pelo SO, não entram nas métricas
+    int endfis;
+    err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
     if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, true);
+      err = mem_le_bloco(self->mem, endfis, n, valores);
     }
+    if (err != ERR_OK) return err;
+    tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, false);
+    endvirt += n;
+    valores += n;
+    tam -= n;
   }
-  return err;
+  return ERR_OK;
+}
+
+err_t mmu_escreve_bloco(mmu_t *self, int endvirt, int tam,
+                        const int valores[tam], cpu_modo_t modo)
+{
+  if (modo == supervisor || self->tabpag == NULL) {
+    return mem_copia_bloco(self->mem, endvirt, tam, valores);
+  }
+  if (endvirt < 0) return ERR_END_INV;
+  while (tam > 0) {
+    // copia até o final da página ou do bloco
+    int n = TAM_PAGINA - endvirt % TAM_PAGINA;
+    if (n > tam) n = tam;
+    int endfis;
+    err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
+    if (err == ERR_OK) {
+      err = mem_copia_bloco(self->mem, endfis, n, valores);
+    }
+    if (err != ERR_OK) return err;
+    tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, true);
+    endvirt += n;
+    valores += n;
+    tam -= n;
+  }
+  return ERR_OK;
+}
+
+long mmu_n_traducoes(mmu_t *self)
+{
+  return self->n_traducoes;
+}
+
+// o id da métrica é 0 para as traduções, 1 para as páginas ausentes
+static long mmu_le_metrica(void *fonte, int id)
+{
+  mmu_t *self = fonte;
+  return id == 0 ? self->n_traducoes : self->n_ausentes;
+}
+
+void mmu_registra_metricas(mmu_t *self, metricas_t *met)
+{
+  met_registra(met, "mmu_traducoes_total", NULL,
+               "Traduções de endereço virtual", MET_CONTADOR,
+               self, 0, mmu_le_metrica);
+  met_registra(met, "mmu_paginas_ausentes_total", NULL,
+               "Traduções que falharam por página ausente", MET_CONTADOR,
+               self, 1, mmu_le_metrica);
 }
@@ -10,6 +10,7 @@
 #include "memoria.h"
 #include "err.h"
 #include "cpu_modo.h"
+#include "metricas.h"
 
 // tipo opaco que representa a MMU
 typedef struct mmu_t mmu_t;
@@ -39,6 +40,12 @@ void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag);
 //   à memória sem tradução
 err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
 
+// como mmu_le em modo usuário, mas sem efeito colateral: não marca a página
+//   como acessada nem conta a tradução nas métricas
+// serve para quem observa a execução (como o amostrador) consultar a
+//   memória do processo sem interferir na substituição de páginas
+err_t mmu_consulta(mmu_t *self, int endvirt, int *pvalor);
+
 // coloca 'valor' no endereço físico da memória correspondente ao endereço
 //   virtual 'endvirt'
 // marca a página como acessada e alterada se o acesso for bem sucedido
@@ -49,4 +56,35 @@ err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
 //   à memória sem tradução
 err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo);
 
+// coloca no vetor 'valores' os 'tam' valores que estão na memória a partir
+//   do endereço virtual 'endvirt'
+// a tradução é feita uma vez por página, e o conteúdo de cada página é
+//   copiado em bloco
+// marca como acessadas as páginas lidas
+// as traduções não são contadas nas métricas nem em mmu_n_traducoes (a
+//   cópia em bloco é usada pelo SO, não pelo programa em execução)
+// retorna erro se alguma das páginas não puder ser acessada; nesse caso,
+//   o conteúdo do vetor pode ter sido parcialmente alterado
+err_t mmu_le_bloco(mmu_t *self, int endvirt, int tam, int valores[tam],
+                   cpu_modo_t modo);
+
+// copia os 'tam' valores do vetor 'valores' para a memória, a partir do
+//   endereço virtual 'endvirt'
+// a tradução é feita uma vez por página, e o conteúdo de cada página é
+//   copiado em bloco
+// marca como acessadas e alteradas as páginas escritas
+// as traduções não são contadas, como em mmu_le_bloco
+// retorna erro se alguma das páginas não puder ser acessada; nesse caso,
+//   as páginas anteriores a ela já foram alteradas
+err_t mmu_escreve_bloco(mmu_t *self, int endvirt, int tam,
+                        const int valores[tam], cpu_modo_t modo);
+
+// retorna o número de traduções de endereço feitas nos acessos da CPU desde
+//   a criação da MMU
+long mmu_n_traducoes(mmu_t *self);
+
+// registra as métricas da MMU: traduções de endereço feitas, e as que
+//   falharam por página ausente
+void mmu_registra_metricas(mmu_t *self, metricas_t *met);
+
 #endif // MMU_H
@@ -7,6 +7,7 @@
 #include <ctype.h>
 
 #include "instrucao.h"
+#include "maqb.h"
 // auxiliares
 
 // aborta o programa com uma mensagem de erro
@@ -39,8 +40,13 @@ int mem[MEM_TAM];
 int mem_pos = 0;        // próxima posição livre da memória
 int mem_min = -1;       // menor endereço preenchido
 int mem_max = -1;       // maior endereço preenchido
+bool mem_espaco[MEM_TAM]; // se a posição foi reservada com ESPACO
+int mem_linha[MEM_TAM];   // linha do fonte que gerou o código que começa na
+                          //   posição (0 se não começa código de linha)
 
 char *nome_fonte;   // nome do arquivo fonte a montar
+char *nome_binario; // nome do arquivo para a saída em formato binário, se houver
+char *nome_simbolos; // nome do arquivo para a tabela de símbolos, se houver
 
 // coloca um valor no final da memória
 void mem_insere(int val)
@@ -75,6 +81,98 @@ void mem_imprime(void)
   }
 }
 
+// escreve uma palavra de 32 bits em little-endian
+void grava_palavra(FILE *arq, int32_t val)
+{
+  uint32_t v = val;
+  for (int i = 0; i < 4; i++) {
+    fputc(v & 0xff, arq);
+    v >>= 8;
+  }
+}
+
+// tamanho mínimo de uma região reservada com ESPACO para que seja gravada
+//   como segmento sem dados no formato binário (regiões menores ficam nos
+//   segmentos de dados, não compensa uma entrada a mais na tabela)
+#define MIN_SEG_ZERO 16
+
+// calcula o tipo e o tamanho do segmento que inicia em 'pos'
+int mem_segmento(int pos, int *ptipo)
+{
+  // vê se é uma região grande de ESPACO
+  int fim = pos;
+  while (fim <= mem_max && mem_espaco[fim]) fim++;
+  if (fim - pos >= MIN_SEG_ZERO) {
+    *ptipo = MAQB_SEG_ZERO;
+    return fim - pos;
+  }
+  // segmento de dados, até o início da próxima região grande de ESPACO
+  *ptipo = MAQB_SEG_DADOS;
+  fim = pos;
+  while (fim <= mem_max) {
+    int fim_espaco = fim;
+    while (fim_espaco <= mem_max && mem_espaco[fim_espaco]) fim_espaco++;
+    if (fim_espaco - fim >= MIN_SEG_ZERO) break;
+    fim = fim_espaco + 1;
+  }
+  if (fim > mem_max + 1) fim = mem_max + 1;
+  return fim - pos;
+}
+
+// grava o conteúdo da memória no formato binário (ver maqb.h)
+// as regiões grandes reservadas com ESPACO são gravadas como segmentos
+//   sem dados, o restante em segmentos de dados
+void mem_grava_binario(char *nome)
+{
+  FILE *arq = fopen(nome, "wb");
+  if (arq == NULL) {
+    fprintf(stderr, "Não foi possível criar o arquivo '%s'\n", nome);
+    exit(1);
+  }
+  int tam = mem_max - mem_min + 1;
+  int tipo;
+  // conta os segmentos
+  int n_seg = 0;
+  for (int pos = mem_min; pos <= mem_max; pos += mem_segmento(pos, &tipo)) {
+    n_seg++;
+  }
+  // cabeçalho
+  grava_palavra(arq, MAQB_MAGICO);
+  grava_palavra(arq, MAQB_VERSAO);
+  grava_palavra(arq, tam);
+  grava_palavra(arq, mem_min);
+  grava_palavra(arq, mem_min);
+  grava_palavra(arq, n_seg);
+  // tabela de segmentos
+  int deslocamento = MAQB_TAM_CABECALHO + n_seg * MAQB_TAM_SEGMENTO;
+  for (int pos = mem_min; pos <= mem_max; ) {
+    int tam_seg = mem_segmento(pos, &tipo);
+    grava_palavra(arq, tipo);
+    grava_palavra(arq, pos);
+    grava_palavra(arq, tam_seg);
+    if (tipo == MAQB_SEG_DADOS) {
+      grava_palavra(arq, deslocamento);
+      deslocamento += tam_seg;
+    } else {
+      grava_palavra(arq, 0);
+    }
+    pos += tam_seg;
+  }
+  // dados
+  for (int pos = mem_min; pos <= mem_max; ) {
+    int tam_seg = mem_segmento(pos, &tipo);
+    if (tipo == MAQB_SEG_DADOS) {
+      for (int i = pos; i < pos + tam_seg; i++) {
+        grava_palavra(arq, mem[i]);
+      }
+    }
+    pos += tam_seg;
+  }
+  if (fclose(arq) != 0) {
+    erro_brabo("erro na gravação do arquivo binário");
+  }
+}
+
 // simbolos
 
 // tabela com os símbolos (labels) já definidos pelo programa, e o valor (endereço) deles
@@ -83,6 +181,7 @@ void mem_imprime(void)
 struct {
   char *nome;
   int valor;
+  bool rotulo;    // se é um label de uma posição (e não definido com DEFINE)
 } simbolo[SIMB_TAM];
 int simb_num;             // número d símbolos na tabela
 
@@ -98,7 +197,7 @@ int simb_valor(char *nome)
 }
 
 // insere um novo símbolo na tabela
-void simb_novo(char *nome, int valor)
+void simb_novo(char *nome, int valor, bool rotulo)
 {
   if (nome == NULL) return;
   if (simb_valor(nome) != -1) {
@@ -110,10 +209,12 @@ void simb_novo(char *nome, int valor)
   }
   simbolo[simb_num].nome = strdup(nome);
   simbolo[simb_num].valor = valor;
+  simbolo[simb_num].rotulo = rotulo;
   simb_num++;
 }
 
 
+
 // referências
 
 // tabela com referências a símbolos
@@ -124,11 +225,12 @@ struct {
   char *nome;
   int linha;
   int endereco;
+  bool chama;     // se é o argumento de uma instrução CHAMA
 } ref[REF_TAM];
 int ref_num;      // numero de referências criadas
 
 // insere uma nova referência na tabela
-void ref_nova(char *nome, int linha, int endereco)
+void ref_nova(char *nome, int linha, int endereco, bool chama)
 {
   if (nome == NULL) return;
   if (ref_num >= REF_TAM) {
@@ -137,6 +239,7 @@ void ref_nova(char *nome, int linha, int endereco)
   ref[ref_num].nome = strdup(nome);
   ref[ref_num].linha = linha;
   ref[ref_num].endereco = endereco;
+  ref[ref_num].chama = chama;
   ref_num++;
 }
 
@@ -155,6 +258,46 @@ void ref_resolve(void)
   }
 }
 
+// grava a tabela de símbolos, para ser usada por quem analisa a execução
+//   do programa (ver tabsimb.h)
+// cada linha tem um tipo, um endereço e às vezes um valor:
+//   R endereço nome    o label 'nome' está no endereço
+//   L endereço linha   o código da linha 'linha' do fonte começa no
+//                      endereço
+//   C endereço         o endereço é chamado por CHAMA (é o início de uma
+//                      subrotina, onde fica o endereço de retorno)
+// os símbolos definidos com DEFINE não são gravados
+void simb_grava(char *nome)
+{
+  FILE *arq = fopen(nome, "w");
+  if (arq == NULL) {
+    fprintf(stderr, "Não foi possível criar o arquivo '%s'\n", nome);
+    exit(1);
+  }
+  fprintf(arq, "# símbolos de '%s'\n", nome_fonte);
+  for (int i = 0; i < simb_num; i++) {
+    if (simbolo[i].rotulo) {
+      fprintf(arq, "R %d %s\n", simbolo[i].valor, simbolo[i].nome);
+    }
+  }
+  for (int pos = mem_min; pos <= mem_max; pos++) {
+    if (mem_linha[pos] != 0) fprintf(arq, "L %d %d\n", pos, mem_linha[pos]);
+  }
+  for (int i = 0; i < ref_num; i++) {
+    if (!ref[i].chama) continue;
+    // só a primeira chamada de cada subrotina
+    int j;
+    for (j = 0; j < i; j++) {
+      if (ref[j].chama && strcmp(ref[j].nome, ref[i].nome) == 0) break;
+    }
+    int valor = simb_valor(ref[i].nome);
+    if (j == i && valor != -1) fprintf(arq, "C %d\n", valor);
+  }
+  if (fclose(arq) != 0) {
+    erro_brabo("erro na gravação da tabela de símbolos");
+  }
+}
+
 
 
 // montagem
@@ -177,6 +320,7 @@ void monta_instrucao(int linha, int opcode, char *arg)
       return;
     }
     for (int i = 0; i < argn; i++) {
+      mem_espaco[mem_pos] = true;
       mem_insere(0);
     }
     return;
@@ -200,7 +344,7 @@ void monta_instrucao(int linha, int opcode, char *arg)
     mem_insere(argn);
   } else {
     // não é número, põe um 0 e insere uma referência para alterar depois
-    ref_nova(arg, linha, mem_pos);
+    ref_nova(arg, linha, mem_pos, opcode == CHAMA);
     mem_insere(0);
   }
 }
@@ -215,7 +359,7 @@ void monta_define(int linha, char *label, char *arg)
     fprintf(stderr, "ERRO: linha %d 'DEFINE' exige valor numérico\n", linha);
   } else {
     // tudo OK, define o símbolo
-    simb_novo(label, argn);
+    simb_novo(label, argn, false);
   }
 }
 
@@ -232,7 +376,7 @@ void monta_linha(int linha, char *label, char *instrucao, char *arg)
   
   // cria símbolo correspondente ao label, se for o caso
   if (label != NULL) {
-    simb_novo(label, mem_pos);
+    simb_novo(label, mem_pos, true);
   }
   
   // verifica a existência de instrução e número correto de argumentos
@@ -254,7 +398,9 @@ void monta_linha(int linha, char *label, char *instrucao, char *arg)
     return;
   }
   // tudo OK, monta a instrução
+  int pos = mem_pos;
   monta_instrucao(linha, opcode, arg);
+  if (mem_pos > pos) mem_linha[pos] = linha;
 }
 
 // retorna true se o caractere for um espaço (ou tab)
@@ -382,13 +528,27 @@ void verifica_args(int argc, char *argv[argc])
         fprintf(stderr, "ERRO: endereço inválido: '%s'\n", argv[argi]);
         exit(1);
       }
+    } else if (strcmp(argv[argi], "-b") == 0) {
+      argi++;
+      if (argi >= argc) {
+        fprintf(stderr, "ERRO: falta nome do arquivo após '-b'\n");
+        exit(1);
+      }
+      nome_binario = argv[argi];
+    } else if (strcmp(argv[argi], "-s") == 0) {
+      argi++;
+      if (argi >= argc) {
+        fprintf(stderr, "ERRO: falta nome do arquivo após '-s'\n");
+        exit(1);
+      }
+      nome_simbolos = argv[argi];
     } else {
       nome_fonte = argv[argi];
     }
   }
   if (nome_fonte == NULL) {
-    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] nome_do_arquivo'\n",
-            argv[0]);
+    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] [-b saida.mqb] "
+                    "[-s saida.sym] nome_do_arquivo'\n", argv[0]);
     exit(1);
   }
 }
@@ -398,5 +558,11 @@ int main(int argc, char *argv[argc])
   verifica_args(argc, argv);
   monta_arquivo(nome_fonte);
   mem_imprime();
+  if (nome_binario != NULL) {
+    mem_grava_binario(nome_binario);
+  }
+  if (nome_simbolos != NULL) {
+    simb_grava(nome_simbolos);
+  }
   return 0;
 }
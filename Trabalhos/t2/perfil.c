@@ -0,0 +1,312 @@
+#include "perfil.h"
+#include "instrucao.h"
+#include "tabsimb.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// número de itens de cada lista do relatório
+#define N_MAIS 15
+// maior endereço contado
+#define MAX_END (1 << 20)
+
+// contagem das instruções de um programa
+typedef struct {
+  char *nome;
+  long n_instrucoes;
+  long n_opcode[N_OPCODE];
+  // n_par[a][b]: quantas vezes b foi executada logo depois de a
+  long n_par[N_OPCODE][N_OPCODE];
+  int op_anterior;
+  // por endereço: execuções, vezes em que desviou e o opcode
+  long *n_end;
+  long *n_desviou;
+  unsigned char *op_end;
+  int tam_end;
+} prog_t;
+
+struct perfil_t {
+  prog_t **progs;
+  int n_progs;
+  prog_t *supervisor;   // instruções executadas em modo supervisor
+  prog_t *usuario;      // programa em execução em modo usuário
+  prog_t *ultimo;       // programa da última instrução contada
+};
+
+static prog_t *prog_cria(char *nome)
+{
+  prog_t *prog = calloc(1, sizeof(*prog));
+  if (prog == NULL) return NULL;
+  prog->nome = strdup(nome);
+  if (prog->nome == NULL) {
+    free(prog);
+    return NULL;
+  }
+  prog->op_anterior = -1;
+  return prog;
+}
+
+static void prog_destroi(prog_t *prog)
+{
+  free(prog->nome);
+  free(prog->n_end);
+  free(prog->n_desviou);
+  free(prog->op_end);
+  free(prog);
+}
+
+// aumenta as tabelas por endereço para conter 'end'
+static bool prog_aumenta(prog_t *prog, int end)
+{
+  int tam = prog->tam_end == 0 ? 256 : prog->tam_end;
+  while (tam <= end) tam *= 2;
+  long *n_end = realloc(prog->n_end, tam * sizeof(long));
+  if (n_end != NULL) prog->n_end = n_end;
+  long *n_desviou = realloc(prog->n_desviou, tam * sizeof(long));
+  if (n_desviou != NULL) prog->n_desviou = n_desviou;
+  unsigned char *op_end = realloc(prog->op_end, tam);
+  if (op_end != NULL) prog->op_end = op_end;
+  if (n_end == NULL || n_desviou == NULL || op_end == NULL) return false;
+  int ant = prog->tam_end;
+  memset(prog->n_end + ant, 0, (tam - ant) * sizeof(long));
+  memset(prog->n_desviou + ant, 0, (tam - ant) * sizeof(long));
+  memset(prog->op_end + ant, 0, tam - ant);
+  prog->tam_end = tam;
+  return true;
+}
+
+perfil_t *perfil_cria(void)
+{
+  perfil_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->progs = NULL;
+  self->n_progs = 0;
+  self->supervisor = prog_cria("(supervisor)");
+  if (self->supervisor == NULL) {
+    free(self);
+    return NULL;
+  }
+  self->usuario = NULL;
+  self->ultimo = NULL;
+  return self;
+}
+
+void perfil_destroi(perfil_t *self)
+{
+  for (int i = 0; i < self->n_progs; i++) {
+    prog_destroi(self->progs[i]);
+  }
+  free(self->progs);
+  prog_destroi(self->supervisor);
+  free(self);
+}
+
+void perfil_define_programa(perfil_t *self, char *nome)
+{
+  self->usuario = NULL;
+  if (nome == NULL) return;
+  for (int i = 0; i < self->n_progs; i++) {
+    if (strcmp(self->progs[i]->nome, nome) == 0) {
+      self->usuario = self->progs[i];
+      return;
+    }
+  }
+  prog_t **progs = realloc(self->progs, (self->n_progs + 1) * sizeof(prog_t *));
+  if (progs == NULL) return;
+  self->progs = progs;
+  prog_t *prog = prog_cria(nome);
+  if (prog == NULL) return;
+  self->progs[self->n_progs++] = prog;
+  self->usuario = prog;
+}
+
+void perfil_conta(perfil_t *self, cpu_modo_t modo, int pc, int opcode,
+                  bool desviou)
+{
+  prog_t *prog = modo == supervisor ? self->supervisor : self->usuario;
+  if (prog == NULL || pc < 0 || pc >= MAX_END) return;
+  if (opcode < 0 || opcode >= N_OPCODE) return;
+  if (pc >= prog->tam_end && !prog_aumenta(prog, pc)) return;
+  prog->n_instrucoes++;
+  prog->n_opcode[opcode]++;
+  prog->n_end[pc]++;
+  prog->op_end[pc] = opcode;
+  if (desviou) prog->n_desviou[pc]++;
+  if (prog == self->ultimo && prog->op_anterior != -1) {
+    prog->n_par[prog->op_anterior][opcode]++;
+  }
+  prog->op_anterior = opcode;
+  self->ultimo = prog;
+}
+
+
+// relatório
+
+// item de uma lista a ordenar pela contagem
+typedef struct {
+  long n;
+  int i;
+} item_t;
+
+static int compara_item(const void *a, const void *b)
+{
+  const item_t *ia = a, *ib = b;
+  if (ia->n != ib->n) return ia->n < ib->n ? 1 : -1;
+  return ia->i - ib->i;
+}
+
+// ordena os itens pela contagem, do maior para o menor, e retorna quantos
+//   não são zero
+static int ordena(item_t *itens, int n)
+{
+  qsort(itens, n, sizeof(item_t), compara_item);
+  while (n > 0 && itens[n - 1].n == 0) n--;
+  return n;
+}
+
+static double pct(long n, long total)
+{
+  return total == 0 ? 0.0 : 100.0 * n / total;
+}
+
+static bool desvio_condicional(int opcode)
+{
+  return opcode == DESVZ || opcode == DESVNZ
+         || opcode == DESVN || opcode == DESVP;
+}
+
+static void grava_rotulos(FILE *arq, prog_t *prog, tabsimb_t *tab)
+{
+  int n_rotulos = tabsimb_n_rotulos(tab);
+  if (n_rotulos == 0) return;
+  // o rótulo de cada endereço é o último antes dele; o índice n_rotulos
+  //   é o dos endereços antes do primeiro rótulo
+  item_t itens[n_rotulos + 1];
+  for (int r = 0; r <= n_rotulos; r++) {
+    itens[r] = (item_t){ 0, r };
+  }
+  for (int end = 0; end < prog->tam_end; end++) {
+    if (prog->n_end[end] == 0) continue;
+    int r = tabsimb_busca_rotulo(tab, end);
+    if (r == -1) r = n_rotulos;
+    itens[r].n += prog->n_end[end];
+  }
+  int n = ordena(itens, n_rotulos + 1);
+  fprintf(arq, "  rótulos mais executados:\n");
+  fprintf(arq, "    %10s %6s  %s\n", "instruções", "%", "rótulo");
+  for (int k = 0; k < n && k < N_MAIS; k++) {
+    int r = itens[k].i, end;
+    fprintf(arq, "    %10ld %5.1f%%  %s\n", itens[k].n,
+            pct(itens[k].n, prog->n_instrucoes),
+            r == n_rotulos ? "(antes do primeiro)"
+                           : tabsimb_rotulo(tab, r, &end));
+  }
+}
+
+// descreve o endereço pela tabela de símbolos, se tiver (sem o arquivo
+//   '.sym', a tabela é NULL ou vazia, e o endereço aparece só pelo número)
+static char *descreve(tabsimb_t *tab, int end, int tam, char desc[tam])
+{
+  if (tab == NULL || tabsimb_n_rotulos(tab) == 0) {
+    desc[0] = '\0';
+    return desc;
+  }
+  return tabsimb_descreve(tab, end, tam, desc);
+}
+
+static void grava_enderecos(FILE *arq, prog_t *prog, tabsimb_t *tab)
+{
+  item_t *itens = malloc(prog->tam_end * sizeof(item_t));
+  if (itens == NULL) return;
+  for (int end = 0; end < prog->tam_end; end++) {
+    itens[end] = (item_t){ prog->n_end[end], end };
+  }
+  int n = ordena(itens, prog->tam_end);
+  char desc[100];
+  fprintf(arq, "  endereços mais executados:\n");
+  fprintf(arq, "    %6s %10s %6s  %-7s %s\n", "end", "instruções", "%",
+          "instr", "local");
+  for (int k = 0; k < n && k < N_MAIS; k++) {
+    int end = itens[k].i;
+    fprintf(arq, "    %6d %10ld %5.1f%%  %-7s %s\n", end, itens[k].n,
+            pct(itens[k].n, prog->n_instrucoes),
+            instrucao_nome(prog->op_end[end]),
+            descreve(tab, end, sizeof(desc), desc));
+  }
+  // desvios condicionais, os mais executados
+  for (int k = 0; k < prog->tam_end; k++) {
+    int end = itens[k].i;
+    if (!desvio_condicional(prog->op_end[end])) itens[k].n = 0;
+  }
+  n = ordena(itens, prog->tam_end);
+  if (n > 0) {
+    fprintf(arq, "  desvios condicionais:\n");
+    fprintf(arq, "    %6s %10s %10s %6s  %-7s %s\n", "end", "execuções",
+            "desviou", "%", "instr", "local");
+  }
+  for (int k = 0; k < n && k < N_MAIS; k++) {
+    int end = itens[k].i;
+    fprintf(arq, "    %6d %10ld %10ld %5.1f%%  %-7s %s\n", end, itens[k].n,
+            prog->n_desviou[end], pct(prog->n_desviou[end], itens[k].n),
+            instrucao_nome(prog->op_end[end]),
+            descreve(tab, end, sizeof(desc), desc));
+  }
+  free(itens);
+}
+
+static void grava_opcodes(FILE *arq, prog_t *prog)
+{
+  item_t itens[N_OPCODE * N_OPCODE];
+  for (int op = 0; op < N_OPCODE; op++) {
+    itens[op] = (item_t){ prog->n_opcode[op], op };
+  }
+  int n = ordena(itens, N_OPCODE);
+  fprintf(arq, "  instruções por opcode:\n");
+  for (int k = 0; k < n; k++) {
+    fprintf(arq, "    %-7s %10ld %5.1f%%\n", instrucao_nome(itens[k].i),
+            itens[k].n, pct(itens[k].n, prog->n_instrucoes));
+  }
+  // os pares mais frequentes são os candidatos a virar uma instrução só
+  for (int a = 0; a < N_OPCODE; a++) {
+    for (int b = 0; b < N_OPCODE; b++) {
+      itens[a * N_OPCODE + b] = (item_t){ prog->n_par[a][b], a * N_OPCODE + b };
+    }
+  }
+  n = ordena(itens, N_OPCODE * N_OPCODE);
+  fprintf(arq, "  pares de instruções executadas em sequência:\n");
+  for (int k = 0; k < n && k < N_MAIS; k++) {
+    int a = itens[k].i / N_OPCODE, b = itens[k].i % N_OPCODE;
+    fprintf(arq, "    %-7s %-7s %10ld %5.1f%%\n", instrucao_nome(a),
+            instrucao_nome(b), itens[k].n,
+            pct(itens[k].n, prog->n_instrucoes));
+  }
+}
+
+static void grava_programa(FILE *arq, prog_t *prog, long total)
+{
+  fprintf(arq, "\nprograma %s: %ld instruções (%.1f%%)\n", prog->nome,
+          prog->n_instrucoes, pct(prog->n_instrucoes, total));
+  if (prog->n_instrucoes == 0) return;
+  tabsimb_t *tab = tabsimb_le(prog->nome);
+  if (tab != NULL) grava_rotulos(arq, prog, tab);
+  grava_enderecos(arq, prog, tab);
+  grava_opcodes(arq, prog);
+  if (tab != NULL) tabsimb_destroi(tab);
+}
+
+bool perfil_grava_relatorio(perfil_t *self, char *nome)
+{
+  FILE *arq = fopen(nome, "w");
+  if (arq == NULL) return false;
+  long total = self->supervisor->n_instrucoes;
+  for (int i = 0; i < self->n_progs; i++) {
+    total += self->progs[i]->n_instrucoes;
+  }
+  fprintf(arq, "perfil de execução: %ld instruções\n", total);
+  for (int i = 0; i < self->n_progs; i++) {
+    grava_programa(arq, self->progs[i], total);
+  }
+  grava_programa(arq, self->supervisor, total);
+  return fclose(arq) == 0;
+}
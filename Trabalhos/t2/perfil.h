@@ -0,0 +1,40 @@
+#ifndef PERFIL_H
+#define PERFIL_H
+
+// perfil de execução
+// conta as instruções executadas pela CPU, por programa: por endereço
+//   (virtual), por opcode, por par de opcodes executados em sequência, e,
+//   para cada desvio condicional, quantas vezes desviou ou não
+// no final, grava um relatório com os rótulos mais executados, usando a
+//   tabela de símbolos gerada pelo montador para cada programa (ver
+//   tabsimb.h)
+// os endereços são os virtuais, que identificam a instrução no programa;
+//   os físicos mudam a cada vez que a página é trazida para a memória
+
+#include <stdbool.h>
+#include "cpu_modo.h"
+
+typedef struct perfil_t perfil_t;
+
+// cria um perfil vazio
+// retorna NULL em caso de erro
+perfil_t *perfil_cria(void);
+
+// destrói o perfil
+void perfil_destroi(perfil_t *self);
+
+// define o programa que a CPU executa em modo usuário ('nome' é o nome do
+//   arquivo executável, NULL se nenhum); as instruções executadas em modo
+//   supervisor são contadas separadamente
+void perfil_define_programa(perfil_t *self, char *nome);
+
+// conta a execução da instrução com 'opcode' no endereço 'pc', em 'modo';
+//   'desviou' diz se a próxima instrução não é a seguinte na memória
+void perfil_conta(perfil_t *self, cpu_modo_t modo, int pc, int opcode,
+                  bool desviou);
+
+// grava o relatório no arquivo 'nome'
+// retorna false em caso de erro
+bool perfil_grava_relatorio(perfil_t *self, char *nome);
+
+#endif // PERFIL_H
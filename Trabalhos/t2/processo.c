@@ -0,0 +1,125 @@
+#include "processo.h"
+#include <stdlib.h>
+#include <string.h>
+
+processo_t *proc_cria(int pid, char *programa)
+{
+  processo_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->tabpag = tabpag_cria();
+  self->programa = strdup(programa);
+  if (self->tabpag == NULL || self->programa == NULL) {
+    if (self->tabpag != NULL) tabpag_destroi(self->tabpag);
+    free(self->programa);
+    free(self);
+    return NULL;
+  }
+  self->n_paginas = 0;
+  self->pagina_sec = NULL;
+  self->pid = pid;
+  self->estado = PROC_PRONTO;
+  self->PC = 0;
+  self->A = 0;
+  self->X = 0;
+  self->erro = ERR_OK;
+  self->complemento = 0;
+  self->modo = usuario;
+  self->terminal = 0;
+  self->prox_espera = NULL;
+  self->es_dados = NULL;
+  self->es_tam = 0;
+  self->es_feitos = 0;
+  self->es_end = 0;
+  self->anel_end = -1;
+  self->anel_n = 0;
+  self->anel_espera = 0;
+  self->anel_op = -1;
+  self->anel_arg = 0;
+  self->anel_pendente = false;
+  self->prox_anel = NULL;
+  temp_no_inicializa(&self->anel_desperta);
+  self->anel_acordou = false;
+  self->bloqueio = BLOQ_NENHUM;
+  self->espera_pid = 0;
+  temp_no_inicializa(&self->desperta);
+  self->quantum = 0;
+  self->nivel = 0;
+  self->epoca = 0;
+  self->nice = 0;
+  self->vruntime = 0;
+  self->t_despacho = 0;
+  self->tempo_real = false;
+  self->periodo = 0;
+  self->wcet = 0;
+  self->prazo = 0;
+  self->liberacao = 0;
+  self->prazo_abs = 0;
+  self->n_ativacoes = 0;
+  self->n_perdas = 0;
+  memset(&self->contas, 0, sizeof(self->contas));
+  self->contas.t_fim = -1;
+  self->contas.t_primeira_exec = -1;
+  self->pronto_no_esc = false;
+  self->ant = NULL;
+  self->prox = NULL;
+  self->filho = NULL;
+  return self;
+}
+
+void proc_destroi(processo_t *self)
+{
+  tabpag_destroi(self->tabpag);
+  free(self->programa);
+  free(self->es_dados);
+  free(self->pagina_sec);
+  free(self);
+}
+
+static char *nomes[N_PROC_ESTADO] = {
+  [PROC_PRONTO] =     "pronto",
+  [PROC_EXECUTANDO] = "executando",
+  [PROC_BLOQUEADO] =  "bloqueado",
+};
+
+char *proc_estado_nome(proc_estado_t estado)
+{
+  if (estado < 0 || estado >= N_PROC_ESTADO) return "DESCONHECIDO";
+  return nomes[estado];
+}
+
+static char *nomes_bloqueio[N_BLOQ] = {
+  [BLOQ_NENHUM] =      "nenhum",
+  [BLOQ_ESPERA_PROC] = "espera_proc",
+  [BLOQ_PERIODO] =     "periodo",
+  [BLOQ_LE] =          "le",
+  [BLOQ_ESCR] =        "escr",
+  [BLOQ_ANEL] =        "anel",
+  [BLOQ_DORME] =       "dorme",
+};
+
+char *proc_bloqueio_nome(proc_bloqueio_t bloqueio)
+{
+  if (bloqueio < 0 || bloqueio >= N_BLOQ) return "DESCONHECIDO";
+  return nomes_bloqueio[bloqueio];
+}
+
+void proc_muda_estado(processo_t *self, proc_estado_t estado, long agora)
+{
+  proc_contas_t *contas = &self->contas;
+  long tempo = agora - contas->t_estado;
+  switch (self->estado) {
+    case PROC_EXECUTANDO:
+      contas->t_executando += tempo;
+      break;
+    case PROC_PRONTO:
+      contas->t_pronto += tempo;
+      break;
+    case PROC_BLOQUEADO:
+      contas->t_bloqueado[self->bloqueio] += tempo;
+      break;
+    default:
+      break;
+  }
+  self->estado = estado;
+  contas->t_estado = agora;
+}
@@ -0,0 +1,160 @@
+#ifndef PROCESSO_H
+#define PROCESSO_H
+
+// descritor de processo
+// contém as informações que o SO mantém sobre cada processo: o estado da
+//   CPU quando ele não está executando, a memória que ele ocupa e o que
+//   é necessário para escalonar e bloquear o processo
+// a estrutura é manipulada diretamente pelo SO e pelo escalonador
+
+#include "cpu_modo.h"
+#include "err.h"
+#include "tabpag.h"
+#include "temporizador.h"
+#include <stdbool.h>
+
+typedef enum {
+  PROC_PRONTO,       // pode executar, está esperando a CPU
+  PROC_EXECUTANDO,   // é o processo corrente
+  PROC_BLOQUEADO,    // esperando algum evento
+  N_PROC_ESTADO
+} proc_estado_t;
+
+// o motivo de um processo estar bloqueado
+typedef enum {
+  BLOQ_NENHUM,
+  BLOQ_ESPERA_PROC,  // esperando o processo 'espera_pid' terminar
+  BLOQ_PERIODO,      // processo de tempo real esperando a próxima ativação
+  BLOQ_LE,           // esperando ter um caractere no teclado do terminal
+  BLOQ_ESCR,         // esperando a tela do terminal ficar livre
+  BLOQ_ANEL,         // esperando completamentos no anel de chamadas
+  BLOQ_DORME,        // esperando passar o tempo pedido em SO_DORME
+  N_BLOQ
+} proc_bloqueio_t;
+
+// número de chamadas de sistema contadas separadamente; as chamadas com
+//   identificação maior (que não existem) são contadas na última
+#define PROC_N_CHAMADAS 32
+
+// contabilidade do processo, para o relatório do SO
+// os tempos são em unidades do relógio; o tempo em cada estado é
+//   acumulado quando o processo sai dele (ver proc_muda_estado)
+typedef struct {
+  long t_criacao;
+  long t_fim;           // -1 se ainda não terminou
+  long t_primeira_exec; // -1 se ainda não executou
+  long t_estado;        // quando entrou no estado atual
+  long t_executando;
+  long t_pronto;
+  long t_bloqueado[N_BLOQ];  // por motivo de bloqueio
+  int n_despachos;      // vezes em que foi escolhido para executar
+  int n_preempcoes;     // vezes em que perdeu a CPU sem ter bloqueado
+  int n_faltas_leves;   // faltas de página sem cópia da memória secundária
+  int n_faltas_pesadas; // faltas de página com cópia da memória secundária
+  int n_chamadas[PROC_N_CHAMADAS];  // chamadas de sistema, por identificação
+} proc_contas_t;
+
+typedef struct processo_t processo_t;
+
+struct processo_t {
+  int pid;
+  char *programa;    // nome do programa que o processo executa
+  proc_estado_t estado;
+  // estado da CPU, enquanto o processo não está executando
+  int PC;
+  int A;
+  int X;
+  err_t erro;
+  int complemento;
+  cpu_modo_t modo;
+  // memória virtual
+  tabpag_t *tabpag;
+  int n_paginas;     // número de páginas do espaço de endereçamento
+  // para cada página, a página da memória secundária onde ela está, ou -1
+  //   se ela não tem conteúdo na memória secundária (é uma página zerada
+  //   por demanda, que ainda não foi alterada)
+  int *pagina_sec;
+  // E/S
+  int terminal;      // terminal usado pelo processo para E/S
+  // encadeamento na fila de espera de um dispositivo, quando bloqueado
+  processo_t *prox_espera;
+  // operação de E/S em andamento
+  int *es_dados;     // caracteres do bloco (NULL se for um só caractere)
+  int es_tam;        // número de caracteres da operação
+  int es_feitos;     // número de caracteres já transferidos
+  int es_end;        // endereço do bloco na memória do processo
+  // anel de chamadas (ver SO_ANEL_REGISTRA em so.h)
+  int anel_end;      // endereço do anel na memória do processo, ou -1
+  int anel_n;        // número de entradas de cada anel
+  int anel_espera;   // completamentos esperados, se bloqueado no anel
+  // pedido que não pôde ser atendido e parou o anel (a operação, ou -1 se
+  //   nenhum), e o seu argumento
+  int anel_op;
+  int anel_arg;
+  // encadeamento na lista de anéis com pedido parado, do SO
+  bool anel_pendente;  // se está na lista
+  processo_t *prox_anel;
+  // evento no temporizador do SO para o fim de um SO_DORME do anel, e se
+  //   ele já aconteceu (o pedido pode ser completado)
+  temp_no_t anel_desperta;
+  bool anel_acordou;
+  // bloqueio
+  proc_bloqueio_t bloqueio;
+  int espera_pid;
+  // evento no temporizador do SO, para o fim de SO_DORME ou a liberação
+  //   do próximo período de tempo real
+  temp_no_t desperta;
+  // escalonamento
+  int quantum;       // interrupções de relógio que ainda pode executar
+  int nivel;         // nível de prioridade (0 é o mais alto), na MLFQ
+  int epoca;         // época do escalonador quando o nível foi definido
+  int nice;          // prioridade estática (menor é mais prioritário)
+  long vruntime;     // tempo virtual de execução, no CFS
+  long t_despacho;   // quando começou a executar (ou foi contabilizado)
+  // tempo real (processo periódico), em unidades de relógio
+  bool tempo_real;   // se é um processo da classe de tempo real
+  int periodo;
+  int wcet;          // tempo de execução no pior caso, em cada período
+  int prazo;         // prazo relativo ao início do período
+  long liberacao;    // início do período atual (ou do próximo, se bloqueado)
+  long prazo_abs;    // prazo da ativação atual
+  int n_ativacoes;
+  int n_perdas;      // ativações que terminaram depois do prazo
+  // contabilidade
+  proc_contas_t contas;
+  // encadeamento nas estruturas de processos prontos do escalonador:
+  //   nas filas circulares, usa 'ant' e 'prox'; no heap de pareamento,
+  //   'filho' é o primeiro filho, 'prox' o próximo irmão e 'ant' o irmão
+  //   anterior (ou o pai, para o primeiro filho)
+  bool pronto_no_esc;   // se está em alguma estrutura do escalonador
+  processo_t *ant;
+  processo_t *prox;
+  processo_t *filho;
+};
+
+// cria um descritor para o processo 'pid', que vai executar o programa
+//   'programa', pronto, com os registradores zerados, em modo usuário, e
+//   com uma tabela de páginas vazia
+// o espaço de endereçamento (n_paginas e pagina_sec) é definido na carga
+//   do programa
+// retorna NULL em caso de erro
+processo_t *proc_cria(int pid, char *programa);
+
+// destrói o descritor (e a tabela de páginas)
+// os quadros e as páginas da memória secundária ocupados pelo processo
+//   devem ter sido liberados antes
+void proc_destroi(processo_t *self);
+
+// muda o estado do processo, acumulando o tempo passado no estado anterior
+//   (se estava bloqueado, no motivo do bloqueio, que deve ser alterado
+//   depois); 'agora' é a hora atual
+// mudar para o mesmo estado só acumula o tempo até agora
+void proc_muda_estado(processo_t *self, proc_estado_t estado, long agora);
+
+// retorna o nome do estado
+char *proc_estado_nome(proc_estado_t estado);
+
+// retorna o nome do motivo de bloqueio
+char *proc_bloqueio_nome(proc_bloqueio_t bloqueio);
+
+#endif // PROCESSO_H
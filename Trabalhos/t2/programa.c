@@ -1,11 +1,32 @@
 #include "programa.h"
+#include "maqb.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// um segmento do programa: uma região contígua de memória
+typedef struct {
+  int ender;
+  int tam;
+  const int *dados;
+} segmento_t;
 
 struct programa_t {
   int carga;
   int tamanho;
+  int inicio;
+  int n_segmentos;
+  segmento_t *segmentos;
+  // dados lidos de um arquivo '.maq' (NULL se for '.mqb')
   int *dados;
+  // arquivo '.mqb' mapeado em memória (NULL se for '.maq')
+  void *mapa;
+  size_t tam_mapa;
 };
 
 // lê os dados do cabeçalho do arquivo (1ª linha)
@@ -17,12 +38,23 @@ static programa_t *pega_cabecalho(char *lin)
   programa_t *prog = malloc(sizeof(*prog));
   if (prog == NULL) return NULL;
   prog->dados = calloc(sizeof(int), tam);
-  if (prog->dados == NULL) {
+  prog->segmentos = malloc(sizeof(segmento_t));
+  if (prog->dados == NULL || prog->segmentos == NULL) {
+    free(prog->dados);
+    free(prog->segmentos);
     free(prog);
     return NULL;
   }
   prog->tamanho = tam;
   prog->carga = carga;
+  prog->inicio = carga;
+  // o programa textual tem um só segmento, com todos os dados
+  prog->n_segmentos = 1;
+  prog->segmentos[0].ender = carga;
+  prog->segmentos[0].tam = tam;
+  prog->segmentos[0].dados = prog->dados;
+  prog->mapa = NULL;
+  prog->tam_mapa = 0;
   return prog;
 }
 
@@ -44,7 +76,8 @@ static void pega_dados(programa_t *self, char *lin)
   }
 }
 
-programa_t *prog_cria(char *nome)
+// lê um programa de um arquivo no formato textual ('.maq')
+static programa_t *prog_cria_maq(char *nome)
 {
   FILE *arq = fopen(nome, "r");
   if (arq == NULL) return NULL;
@@ -63,8 +96,143 @@ fim:
   return prog;
 }
 
+// verifica se o conteúdo de um arquivo '.mqb' mapeado em memória é
+//   coerente, e preenche o programa com os segmentos
+static bool pega_mqb(programa_t *self)
+{
+  const int32_t *palavras = self->mapa;
+  size_t n_palavras = self->tam_mapa / sizeof(int32_t);
+  if (n_palavras < MAQB_TAM_CABECALHO) return false;
+  const maqb_cabecalho_t *cab = self->mapa;
+  if (cab->magico != MAQB_MAGICO || cab->versao != MAQB_VERSAO) return false;
+  if (cab->carga < 0 || cab->tamanho < 0 || cab->n_segmentos < 0) {
+    return false;
+  }
+  // o início da execução tem que estar no programa
+  if (cab->inicio < cab->carga
+      || (long)cab->inicio - cab->carga >= cab->tamanho) {
+    return false;
+  }
+  size_t fim_tabela = MAQB_TAM_CABECALHO
+                    + (size_t)cab->n_segmentos * MAQB_TAM_SEGMENTO;
+  if (fim_tabela > n_palavras) return false;
+  self->carga = cab->carga;
+  self->tamanho = cab->tamanho;
+  self->inicio = cab->inicio;
+  self->n_segmentos = cab->n_segmentos;
+  self->segmentos = malloc(self->n_segmentos * sizeof(segmento_t));
+  if (self->segmentos == NULL && self->n_segmentos > 0) return false;
+  const maqb_segmento_t *tab = (const void *)&palavras[MAQB_TAM_CABECALHO];
+  for (int seg = 0; seg < self->n_segmentos; seg++) {
+    const maqb_segmento_t *s = &tab[seg];
+    // em long, para a soma não estourar
+    if (s->tamanho < 0 || s->endereco < self->carga
+        || (long)s->endereco - self->carga + s->tamanho > self->tamanho) {
+      return false;
+    }
+    self->segmentos[seg].ender = s->endereco;
+    self->segmentos[seg].tam = s->tamanho;
+    if (s->tipo == MAQB_SEG_ZERO) {
+      // não tem dados no arquivo
+      self->segmentos[seg].dados = NULL;
+      continue;
+    }
+    if (s->tipo != MAQB_SEG_DADOS
+        || s->deslocamento < 0 || (size_t)s->deslocamento < fim_tabela
+        || (size_t)s->deslocamento + s->tamanho > n_palavras) {
+      return false;
+    }
+    // os dados são usados diretamente do arquivo mapeado
+    self->segmentos[seg].dados = &palavras[s->deslocamento];
+  }
+  return true;
+}
+
+// lê um programa de um arquivo no formato binário ('.mqb')
+// o arquivo é mapeado em memória, e os dados dos segmentos são usados
+//   diretamente de lá
+static programa_t *prog_cria_mqb(char *nome)
+{
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+  // as palavras do arquivo não podem ser usadas diretamente
+  return NULL;
+#endif
+  int fd = open(nome, O_RDONLY);
+  if (fd == -1) return NULL;
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  programa_t *prog = malloc(sizeof(*prog));
+  if (prog == NULL) {
+    close(fd);
+    return NULL;
+  }
+  prog->dados = NULL;
+  prog->segmentos = NULL;
+  prog->tam_mapa = st.st_size;
+  prog->mapa = mmap(NULL, prog->tam_mapa, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (prog->mapa == MAP_FAILED) {
+    free(prog);
+    return NULL;
+  }
+  if (!pega_mqb(prog)) {
+    prog_destroi(prog);
+    return NULL;
+  }
+  return prog;
+}
+
+// retorna true se o nome termina com o sufixo
+static bool termina_com(char *nome, char *sufixo)
+{
+  size_t tam_nome = strlen(nome);
+  size_t tam_sufixo = strlen(sufixo);
+  if (tam_nome < tam_sufixo) return false;
+  return strcmp(nome + tam_nome - tam_sufixo, sufixo) == 0;
+}
+
+// se 'nome' for um arquivo '.maq' e existir o '.mqb' correspondente, que não
+//   seja mais antigo que ele, coloca o nome do '.mqb' em nome_mqb
+static bool tem_mqb(char *nome, int tam, char nome_mqb[tam])
+{
+  if (!termina_com(nome, ".maq")) return false;
+  if (snprintf(nome_mqb, tam, "%s", nome) >= tam) return false;
+  strcpy(nome_mqb + strlen(nome_mqb) - 3, "mqb");
+  struct stat st_maq, st_mqb;
+  if (stat(nome_mqb, &st_mqb) == -1) return false;
+  if (stat(nome, &st_maq) == 0 && st_maq.st_mtime > st_mqb.st_mtime) {
+    return false;
+  }
+  return true;
+}
+
+bool prog_arquivo(char *nome, int tam, char arquivo[tam])
+{
+  if (tem_mqb(nome, tam, arquivo)) return true;
+  return snprintf(arquivo, tam, "%s", nome) < tam;
+}
+
+programa_t *prog_cria(char *nome)
+{
+  if (termina_com(nome, ".mqb")) {
+    return prog_cria_mqb(nome);
+  }
+  // dá preferência para o formato binário, se estiver atualizado
+  char nome_mqb[strlen(nome) + 1];
+  if (tem_mqb(nome, sizeof(nome_mqb), nome_mqb)) {
+    programa_t *prog = prog_cria_mqb(nome_mqb);
+    if (prog != NULL) return prog;
+  }
+  return prog_cria_maq(nome);
+}
+
 void prog_destroi(programa_t *self)
 {
+  if (self->mapa != NULL) munmap(self->mapa, self->tam_mapa);
+  free(self->segmentos);
   free(self->dados);
   free(self);
 }
@@ -81,11 +249,31 @@ int prog_end_carga(programa_t *self)
 
 int prog_end_inicio(programa_t *self)
 {
-  return self->carga;
+  return self->inicio;
 }
 
 int prog_dado(programa_t *self, int ender)
 {
+  for (int seg = 0; seg < self->n_segmentos; seg++) {
+    segmento_t *s = &self->segmentos[seg];
+    if (ender >= s->ender && ender < s->ender + s->tam) {
+      if (s->dados == NULL) return 0;
+      return s->dados[ender - s->ender];
+    }
+  }
   if (ender < self->carga || ender >= self->carga + self->tamanho) return -1;
-  return self->dados[ender - self->carga];
+  return 0;
+}
+
+int prog_num_segmentos(programa_t *self)
+{
+  return self->n_segmentos;
+}
+
+const int *prog_segmento(programa_t *self, int seg, int *pender, int *ptam)
+{
+  if (seg < 0 || seg >= self->n_segmentos) return NULL;
+  *pender = self->segmentos[seg].ender;
+  *ptam = self->segmentos[seg].tam;
+  return self->segmentos[seg].dados;
 }
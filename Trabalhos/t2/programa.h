@@ -1,14 +1,24 @@
 #ifndef PROGRAMA_H
 #define PROGRAMA_H
 
-// TAD para representar um programa lido de um arquivo '.maq'
+// TAD para representar um programa lido de um arquivo '.maq' (textual)
+//   ou '.mqb' (binário, ver maqb.h)
+
+#include <stdbool.h>
 
 typedef struct programa_t programa_t;
 
 // cria e inicializa um programa com o conteúdo do arquivo 'nome'
+// se 'nome' for um arquivo '.maq' e existir o '.mqb' correspondente, mais
+//   novo, o programa é lido do '.mqb'
 // retorna NULL em caso de erro
 programa_t *prog_cria(char *nome);
 
+// coloca em 'arquivo' o nome do arquivo que prog_cria lê para 'nome': o
+//   '.mqb' correspondente, se estiver atualizado, ou o próprio 'nome'
+// retorna false se o nome não couber em 'arquivo'
+bool prog_arquivo(char *nome, int tam, char arquivo[tam]);
+
 // destrói um programa
 // nenhuma outra operação pode ser realizada no programa após esta chamada
 void prog_destroi(programa_t *self);
@@ -26,4 +36,19 @@ int prog_end_inicio(programa_t *self);
 // valor a colocar na posição 'ender' da memória
 int prog_dado(programa_t *self, int ender);
 
+// Um programa é formado por segmentos, regiões contíguas de memória com
+//   os valores a carregar. Alguns segmentos não têm valores, só reservam
+//   espaço que deve ser inicializado com 0 (como os gerados por ESPACO no
+//   formato binário). As posições do programa que não pertencem a nenhum
+//   segmento também devem ser inicializadas com 0.
+
+// número de segmentos do programa
+int prog_num_segmentos(programa_t *self);
+
+// coloca em '*pender' e '*ptam' o endereço de carga e o tamanho do
+//   segmento 'seg', e retorna o vetor com seus valores
+// o vetor pertence ao programa, é válido até prog_destroi
+// retorna NULL se o segmento deve ser inicializado com 0, ou se não existir
+const int *prog_segmento(programa_t *self, int seg, int *pender, int *ptam);
+
 #endif // PROGRAMA_H
@@ -0,0 +1,53 @@
+#include "rastro.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static struct {
+  FILE *arquivo;          // NULL se o rastro não foi iniciado
+  struct timespec t_inicio;
+  rastro_evento_t eventos[RASTRO_N_EVENTOS];
+  int n_eventos;
+} rastro = { .arquivo = NULL };
+
+static void rastro_esvazia(void)
+{
+  fwrite(rastro.eventos, sizeof(rastro_evento_t), rastro.n_eventos,
+         rastro.arquivo);
+  rastro.n_eventos = 0;
+}
+
+bool rastro_inicia(char *nome)
+{
+  rastro.arquivo = fopen(nome, "wb");
+  if (rastro.arquivo == NULL) return false;
+  int32_t cabecalho[2] = { RASTRO_MAGICO, RASTRO_VERSAO };
+  fwrite(cabecalho, sizeof(cabecalho), 1, rastro.arquivo);
+  clock_gettime(CLOCK_MONOTONIC, &rastro.t_inicio);
+  rastro.n_eventos = 0;
+  return true;
+}
+
+void rastro_registra(rastro_tipo_t tipo, long momento, int pid, int a, int b)
+{
+  if (rastro.arquivo == NULL) return;
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  rastro_evento_t *ev = &rastro.eventos[rastro.n_eventos++];
+  ev->momento = momento;
+  ev->hospedeiro = (int64_t)(t.tv_sec - rastro.t_inicio.tv_sec) * 1000000000
+                   + (t.tv_nsec - rastro.t_inicio.tv_nsec);
+  ev->tipo = tipo;
+  ev->pid = pid;
+  ev->a = a;
+  ev->b = b;
+  if (rastro.n_eventos == RASTRO_N_EVENTOS) rastro_esvazia();
+}
+
+void rastro_termina(void)
+{
+  if (rastro.arquivo == NULL) return;
+  rastro_esvazia();
+  fclose(rastro.arquivo);
+  rastro.arquivo = NULL;
+}
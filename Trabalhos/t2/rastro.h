@@ -0,0 +1,74 @@
+#ifndef RASTRO_H
+#define RASTRO_H
+
+// rastro de eventos
+// registra eventos do SO (interrupções, despachos, faltas de página,
+//   transferências com a memória secundária, chamadas de sistema, criação
+//   e fim de processos) em formato binário, para serem analisados depois
+//   da execução; o programa rastro_json converte o arquivo para o formato
+//   de rastro do Chrome (que o Perfetto também lê), para ver a linha do
+//   tempo dos processos
+// só é compilado se RASTRO estiver definido (ver Makefile); senão as
+//   macros abaixo não geram código, e os seus argumentos nem são avaliados
+// os eventos são colocados em um buffer de tamanho fixo, que é gravado no
+//   arquivo quando enche e no final da execução; como o simulador tem uma
+//   só thread, o rastro é global, com um só buffer
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// número de eventos no buffer
+#define RASTRO_N_EVENTOS 8192
+
+// o arquivo começa com estes dois valores (int32_t), seguidos dos eventos
+#define RASTRO_MAGICO 0x52545352   // "RSTR"
+#define RASTRO_VERSAO 1
+
+// tipos de evento, e o significado dos campos de cada um
+typedef enum {
+  RASTRO_IRQ_ENTRA,   // início do atendimento de interrupção; a = irq
+  RASTRO_IRQ_SAI,     // fim do atendimento; a = irq
+  RASTRO_DESPACHO,    // pid = processo que vai executar (0 se nenhum)
+  RASTRO_FALTA_INI,   // início de falta de página; a = página
+  RASTRO_FALTA_FIM,   // fim; a = página, b = quadro (-1 se não atendeu)
+  RASTRO_MEM_SEC,     // cópia de página com a memória secundária;
+                      //   a = página, b = 0 para leitura, 1 para escrita
+  RASTRO_CHAMADA,     // chamada de sistema; a = identificação
+  RASTRO_PROC_CRIA,   // criação de processo
+  RASTRO_PROC_FIM,    // fim de processo
+  RASTRO_N_TIPOS
+} rastro_tipo_t;
+
+// um evento, como é gravado no arquivo
+typedef struct {
+  int64_t momento;      // tempo do relógio simulado
+  int64_t hospedeiro;   // tempo do hospedeiro, em ns desde o início
+  int32_t tipo;
+  int32_t pid;
+  int32_t a;
+  int32_t b;
+} rastro_evento_t;
+
+// começa o rastro, no arquivo 'nome'
+// retorna false em caso de erro (e os eventos são ignorados)
+bool rastro_inicia(char *nome);
+
+// registra um evento
+void rastro_registra(rastro_tipo_t tipo, long momento, int pid, int a, int b);
+
+// grava os eventos que estão no buffer e fecha o arquivo
+void rastro_termina(void);
+
+// sem RASTRO, as macros não geram código, e RASTRO_INICIA dá sempre true
+#ifdef RASTRO
+#define RASTRO_INICIA(nome) rastro_inicia(nome)
+#define RASTRO_EVENTO(tipo, momento, pid, a, b) \
+  rastro_registra(tipo, momento, pid, a, b)
+#define RASTRO_TERMINA() rastro_termina()
+#else
+#define RASTRO_INICIA(nome) (true)
+#define RASTRO_EVENTO(tipo, momento, pid, a, b) ((void)0)
+#define RASTRO_TERMINA() ((void)0)
+#endif
+
+#endif // RASTRO_H
@@ -0,0 +1,177 @@
+// rastro_json
+// converte um arquivo de rastro do simulador (ver rastro.h) para o formato
+//   de rastro do Chrome (JSON), que pode ser visto em chrome://tracing ou
+//   no Perfetto (ui.perfetto.dev)
+// uso: rastro_json [-h] rastro.bin > rastro.json
+//   -h    usa o tempo do hospedeiro em vez do tempo simulado
+// cada unidade do relógio simulado aparece como um microssegundo
+// na linha do tempo, o grupo "processos" tem uma linha por processo, com
+//   os intervalos em que ele executou, as faltas de página e as chamadas
+//   de sistema; o grupo "SO" tem o atendimento das interrupções e as
+//   transferências com a memória secundária
+
+#include "rastro.h"
+#include "irq.h"
+#include "chamada.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// identificação dos grupos e linhas no formato do Chrome
+#define GRUPO_SO         0
+#define GRUPO_PROCESSOS  1
+#define LINHA_IRQ        0
+#define LINHA_MEM_SEC    1
+
+static bool usa_hospedeiro = false;
+static bool primeiro = true;
+
+// o tempo do evento, em microssegundos
+static double tempo(rastro_evento_t *ev)
+{
+  if (usa_hospedeiro) return ev->hospedeiro / 1000.0;
+  return ev->momento;
+}
+
+// começa um evento no formato do Chrome; os campos de cada um são
+//   completados por quem chama
+static void inicia_evento(char *fase, char *nome, int grupo, int linha,
+                          double ts)
+{
+  printf("%s\n  {\"ph\": \"%s\", \"name\": \"%s\", \"pid\": %d, \"tid\": %d,"
+         " \"ts\": %.3f", primeiro ? "" : ",", fase, nome, grupo, linha, ts);
+  primeiro = false;
+}
+
+static void nomeia(char *tipo, int grupo, int linha, char *nome)
+{
+  inicia_evento("M", tipo, grupo, linha, 0);
+  printf(", \"args\": {\"name\": \"%s\"}}", nome);
+}
+
+// linhas dos processos que já receberam nome
+#define MAX_PID 100000
+static bool nomeado[MAX_PID];
+
+static void nomeia_processo(int pid)
+{
+  if (pid <= 0 || pid >= MAX_PID || nomeado[pid]) return;
+  char nome[30];
+  sprintf(nome, "processo %d", pid);
+  nomeia("thread_name", GRUPO_PROCESSOS, pid, nome);
+  nomeado[pid] = true;
+}
+
+// processo em execução, e desde quando
+static int pid_executando = 0;
+static double t_executando;
+
+static void fecha_execucao(double ts)
+{
+  if (pid_executando == 0) return;
+  inicia_evento("X", "executando", GRUPO_PROCESSOS, pid_executando,
+                t_executando);
+  printf(", \"dur\": %.3f}", ts - t_executando);
+  pid_executando = 0;
+}
+
+static void converte(rastro_evento_t *ev)
+{
+  double ts = tempo(ev);
+  char nome[50];
+  nomeia_processo(ev->pid);
+  switch (ev->tipo) {
+    case RASTRO_IRQ_ENTRA:
+    case RASTRO_IRQ_SAI:
+      inicia_evento(ev->tipo == RASTRO_IRQ_ENTRA ? "B" : "E",
+                    irq_nome(ev->a), GRUPO_SO, LINHA_IRQ, ts);
+      printf("}");
+      break;
+    case RASTRO_DESPACHO:
+      if (ev->pid == pid_executando) break;
+      fecha_execucao(ts);
+      pid_executando = ev->pid;
+      t_executando = ts;
+      break;
+    case RASTRO_FALTA_INI:
+      inicia_evento("B", "falta de página", GRUPO_PROCESSOS, ev->pid, ts);
+      printf(", \"args\": {\"página\": %d}}", ev->a);
+      break;
+    case RASTRO_FALTA_FIM:
+      inicia_evento("E", "falta de página", GRUPO_PROCESSOS, ev->pid, ts);
+      printf(", \"args\": {\"quadro\": %d}}", ev->b);
+      break;
+    case RASTRO_MEM_SEC:
+      inicia_evento("i", ev->b == 0 ? "lê página" : "escreve página",
+                    GRUPO_SO, LINHA_MEM_SEC, ts);
+      printf(", \"s\": \"t\", \"args\": {\"pid\": %d, \"página\": %d}}",
+             ev->pid, ev->a);
+      break;
+    case RASTRO_CHAMADA:
+      if (chamada_nome(ev->a) != NULL) {
+        sprintf(nome, "chamada %s", chamada_nome(ev->a));
+      } else {
+        sprintf(nome, "chamada %d", ev->a);
+      }
+      inicia_evento("i", nome, GRUPO_PROCESSOS, ev->pid, ts);
+      printf(", \"s\": \"t\"}");
+      break;
+    case RASTRO_PROC_CRIA:
+    case RASTRO_PROC_FIM:
+      if (ev->tipo == RASTRO_PROC_FIM && ev->pid == pid_executando) {
+        fecha_execucao(ts);
+      }
+      inicia_evento("i", ev->tipo == RASTRO_PROC_CRIA ? "criação" : "fim",
+                    GRUPO_PROCESSOS, ev->pid, ts);
+      printf(", \"s\": \"t\"}");
+      break;
+    default:
+      fprintf(stderr, "ERRO: evento de tipo desconhecido (%d)\n", ev->tipo);
+  }
+}
+
+int main(int argc, char *argv[argc])
+{
+  char *nome = NULL;
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "-h") == 0) {
+      usa_hospedeiro = true;
+    } else {
+      nome = argv[argi];
+    }
+  }
+  if (nome == NULL) {
+    fprintf(stderr, "ERRO: chame como '%s [-h] rastro.bin'\n", argv[0]);
+    return 1;
+  }
+  FILE *arq = fopen(nome, "rb");
+  if (arq == NULL) {
+    fprintf(stderr, "Não foi possível abrir o arquivo '%s'\n", nome);
+    return 1;
+  }
+  int32_t cabecalho[2];
+  if (fread(cabecalho, sizeof(cabecalho), 1, arq) != 1
+      || cabecalho[0] != RASTRO_MAGICO || cabecalho[1] != RASTRO_VERSAO) {
+    fprintf(stderr, "ERRO: '%s' não é um arquivo de rastro\n", nome);
+    fclose(arq);
+    return 1;
+  }
+
+  printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+  nomeia("process_name", GRUPO_SO, 0, "SO");
+  nomeia("process_name", GRUPO_PROCESSOS, 0, "processos");
+  nomeia("thread_name", GRUPO_SO, LINHA_IRQ, "interrupções");
+  nomeia("thread_name", GRUPO_SO, LINHA_MEM_SEC, "memória secundária");
+  rastro_evento_t ev;
+  double t_fim = 0;
+  while (fread(&ev, sizeof(ev), 1, arq) == 1) {
+    converte(&ev);
+    t_fim = tempo(&ev);
+  }
+  fecha_execucao(t_fim);
+  printf("\n]}\n");
+  fclose(arq);
+  return 0;
+}
@@ -1,11 +1,28 @@
 #include "relogio.h"
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
 #include <time.h>
 
-struct relogio_t {
-  int agora;             // que horas são
-  int t_ate_interrupcao; // quanto tempo até gerar uma interrupcao
+// um canal de interrupção
+typedef struct {
+  long prazo;            // quando vai gerar interrupção (-1 se não vai)
   int interrupcao;       // 1 se está gerando interrupcao, 0 se não
+} canal_t;
+
+struct relogio_t {
+  long agora;            // que horas são
+  canal_t canais[REL_N_CANAIS];
+  // o menor prazo dos canais (LONG_MAX se nenhum está programado), para
+  //   que a passagem do tempo só compare com ele
+  long prox_prazo;
+  // tempo do hospedeiro na criação do relógio
+  struct timespec t_criacao;
+  // partes de cima dos valores de 64 bits, guardadas na leitura das partes
+  //   de baixo
+  int agora_alto;
+  int hospedeiro_alto;
 };
 
 relogio_t *rel_cria(void)
@@ -14,8 +31,14 @@ relogio_t *rel_cria(void)
   self = malloc(sizeof(relogio_t));
   if (self != NULL) {
     self->agora = 0;
-    self->t_ate_interrupcao = 0;
-    self->interrupcao = 0;
+    for (int c = 0; c < REL_N_CANAIS; c++) {
+      self->canais[c].prazo = -1;
+      self->canais[c].interrupcao = 0;
+    }
+    self->prox_prazo = LONG_MAX;
+    clock_gettime(CLOCK_MONOTONIC, &self->t_criacao);
+    self->agora_alto = 0;
+    self->hospedeiro_alto = 0;
   }
   return self;
 }
@@ -25,42 +48,97 @@ void rel_destroi(relogio_t *self)
   free(self);
 }
 
+// recalcula o menor prazo dos canais
+static void calcula_prox_prazo(relogio_t *self)
+{
+  self->prox_prazo = LONG_MAX;
+  for (int c = 0; c < REL_N_CANAIS; c++) {
+    long prazo = self->canais[c].prazo;
+    if (prazo != -1 && prazo < self->prox_prazo) self->prox_prazo = prazo;
+  }
+}
+
 void rel_tictac(relogio_t *self)
 {
   self->agora++;
   // vê se tem que gerar interrupção
-  if (self->t_ate_interrupcao != 0) {
-    self->t_ate_interrupcao--;
-    if (self->t_ate_interrupcao == 0) {
-      self->interrupcao = 1;
+  if (self->agora < self->prox_prazo) return;
+  for (int c = 0; c < REL_N_CANAIS; c++) {
+    if (self->canais[c].prazo == self->agora) {
+      self->canais[c].prazo = -1;
+      self->canais[c].interrupcao = 1;
     }
   }
+  calcula_prox_prazo(self);
 }
 
-int rel_agora(relogio_t *self)
+long rel_agora(relogio_t *self)
 {
   return self->agora;
 }
 
+long rel_proximo_prazo(relogio_t *self)
+{
+  if (self->prox_prazo == LONG_MAX) return -1;
+  return self->prox_prazo;
+}
+
+// tempo do hospedeiro desde a criação do relógio, em microssegundos
+static int64_t tempo_hospedeiro(relogio_t *self)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (int64_t)(t.tv_sec - self->t_criacao.tv_sec) * 1000000
+         + (t.tv_nsec - self->t_criacao.tv_nsec) / 1000;
+}
+
+// retorna o canal correspondente ao dispositivo 'id', ou -1; em *pcontador
+//   diz se é o dispositivo do contador ou o do pedido de interrupção
+static int canal_do_dispositivo(int id, bool *pcontador)
+{
+  for (int c = 0; c < REL_N_CANAIS; c++) {
+    if (id == REL_CONTADOR(c) || id == REL_INTERRUPCAO(c)) {
+      *pcontador = (id == REL_CONTADOR(c));
+      return c;
+    }
+  }
+  return -1;
+}
+
 err_t rel_le(void *disp, int id, int *pvalor)
 {
   relogio_t *self = disp;
   err_t err = ERR_OK;
+  int64_t valor;
   switch (id) {
-    case 0:
-      *pvalor = self->agora;
+    case REL_AGORA:
+      valor = self->agora;
+      *pvalor = (int32_t)valor;
+      self->agora_alto = (int32_t)(valor >> 32);
       break;
-    case 1:
-      *pvalor = clock()/(CLOCKS_PER_SEC/1000);
+    case REL_HOSPEDEIRO:
+      valor = tempo_hospedeiro(self);
+      *pvalor = (int32_t)valor;
+      self->hospedeiro_alto = (int32_t)(valor >> 32);
       break;
-    case 2:
-      *pvalor = self->t_ate_interrupcao;
+    case REL_AGORA_ALTO:
+      *pvalor = self->agora_alto;
       break;
-    case 3:
-      *pvalor = self->interrupcao;
+    case REL_HOSPEDEIRO_ALTO:
+      *pvalor = self->hospedeiro_alto;
       break;
-    default: 
-      err = ERR_END_INV;
+    default: {
+      bool contador;
+      int c = canal_do_dispositivo(id, &contador);
+      if (c == -1) {
+        err = ERR_END_INV;
+      } else if (contador) {
+        canal_t *canal = &self->canais[c];
+        *pvalor = canal->prazo == -1 ? 0 : canal->prazo - self->agora;
+      } else {
+        *pvalor = self->canais[c].interrupcao;
+      }
+    }
   }
   return err;
 }
@@ -68,16 +146,15 @@ err_t rel_le(void *disp, int id, int *pvalor)
 err_t rel_escr(void *disp, int id, int pvalor)
 {
   relogio_t *self = disp;
-  err_t err = ERR_OK;
-  switch (id) {
-    case 2:
-      self->t_ate_interrupcao = pvalor;
-      break;
-    case 3:
-      self->interrupcao = (pvalor == 0) ? 0 : 1;
-      break;
-    default: 
-      err = ERR_END_INV;
+  bool contador;
+  int c = canal_do_dispositivo(id, &contador);
+  if (c == -1) return ERR_END_INV;
+  canal_t *canal = &self->canais[c];
+  if (contador) {
+    canal->prazo = (pvalor <= 0) ? -1 : self->agora + pvalor;
+    calcula_prox_prazo(self);
+  } else {
+    canal->interrupcao = (pvalor == 0) ? 0 : 1;
   }
-  return err;
+  return ERR_OK;
 }
@@ -3,9 +3,17 @@
 
 // simulador do relógio
 // registra a passagem do tempo
+// o contador de tempo tem 64 bits; os dispositivos de E/S têm 32, e o
+//   contador é lido em duas partes
+// o relógio tem REL_N_CANAIS canais de interrupção independentes; cada
+//   canal é programado para interromper depois de um certo tempo, e tem o
+//   seu próprio pedido de interrupção
 
 #include "err.h"
 
+// número de canais de interrupção
+#define REL_N_CANAIS 4
+
 typedef struct relogio_t relogio_t;
 
 // cria e inicializa um relógio
@@ -21,14 +29,33 @@ void rel_destroi(relogio_t *self);
 void rel_tictac(relogio_t *self);
 
 // retorna a hora atual do sistema, em unidades de tempo
-int rel_agora(relogio_t *self);
+long rel_agora(relogio_t *self);
+
+// retorna o momento em que o próximo canal vai pedir interrupção, ou -1
+//   se nenhum canal está programado
+// até esse momento, nenhum pedido de interrupção do relógio muda (a não
+//   ser que algum canal seja reprogramado)
+long rel_proximo_prazo(relogio_t *self);
 
 // Funções para acessar o relógio como um dispositivo de E/S
-//   tem quatro dispositivos:
-//   '0' para ler o relógio local (contador de instruções)
-//   '1' para ler o relógio de tempo de CPU consumido pelo simulador (em ms)
-//   '2' para ler ou escrever em quanto tempo uma interrupção será gerada
-//   '3' para ler ou escrever se uma interrupção está sendo pedida
+//   REL_AGORA            lê os 32 bits de baixo do contador de tempo; os
+//                        32 de cima são guardados, para serem lidos em
+//                        REL_AGORA_ALTO
+//   REL_HOSPEDEIRO       lê os 32 bits de baixo do tempo do hospedeiro
+//                        desde a criação do relógio, em microssegundos;
+//                        os de cima são lidos em REL_HOSPEDEIRO_ALTO
+//   REL_CONTADOR(c)      lê ou escreve em quanto tempo o canal c vai pedir
+//                        interrupção (0 se não está programado; escrever
+//                        0 desprograma o canal)
+//   REL_INTERRUPCAO(c)   lê ou escreve se o canal c está pedindo
+//                        interrupção (escrever 0 desliga o pedido)
+// os dispositivos do canal 0 são os mesmos do relógio com um só canal
+#define REL_AGORA               0
+#define REL_HOSPEDEIRO          1
+#define REL_AGORA_ALTO          4
+#define REL_HOSPEDEIRO_ALTO     5
+#define REL_CONTADOR(c)         ((c) == 0 ? 2 : 4 + 2 * (c))
+#define REL_INTERRUPCAO(c)      (REL_CONTADOR(c) + 1)
 err_t rel_le(void *disp, int id, int *pvalor);
 err_t rel_escr(void *disp, int id, int pvalor);
 
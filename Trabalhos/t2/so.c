@@ -1,38 +1,209 @@
 #include "so.h"
 #include "irq.h"
 #include "programa.h"
+#include "cacheprog.h"
+#include "chamada.h"
 #include "instrucao.h"
 #include "tabpag.h"
+#include "processo.h"
+#include "escalonador.h"
+#include "rastro.h"
+#include "cronometro.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
 
 // intervalo entre interrupções do relógio
 #define INTERVALO_INTERRUPCAO 50   // em instruções executadas
 
-// Não tem processos nem memória virtual, mas é preciso usar a paginação,
-//   pelo menos para implementar relocação, já que os programas estão sendo
-//   todos montados para serem executados no endereço 0 e o endereço 0
-//   físico é usado pelo hardware nas interrupções.
-// Os programas vão ser carregados no início de um quadro, e usar quantos
-//   quadros forem necessárias. Para isso a variável quadro_livre vai conter
-//   o número do primeiro quadro da memória principal que ainda não foi usado.
-//   Na carga do processo, a tabela de páginas (deveria ter uma por processo,
-//   mas não tem processo) é alterada para que o endereço virtual 0 resulte
-//   no quadro onde o programa foi carregado.
+// tic dinâmico: quando só tem um processo que pode executar, o relógio não
+//   interrompe a cada tic de quantum, mas só no fim do quantum (ou antes,
+//   no próximo evento do temporizador); os tics que passaram são
+//   contabilizados na próxima interrupção, qualquer que seja ela
+// com false, o relógio interrompe a cada tic enquanto a CPU está ocupada
+#define TIC_DINAMICO true
+
+// canais do relógio usados pelo SO (ver relogio.h)
+#define CANAL_QUANTUM      0   // tics de quantum, interrompe com IRQ_RELOGIO
+#define CANAL_TEMPORIZADOR 1   // eventos do temporizador, com IRQ_RELOGIO_1
+
+// primeiro quadro da memória principal que pode ser usado por programas
+//   de usuário (as 100 primeiras posições de memória não vão ser usadas
+//   por programas de usuário)
+#define QUADRO_INI_USUARIO (99 / TAM_PAGINA + 1)
+
+// número de programas mantidos no cache de programas
+#define TAM_CACHE_PROG 8
+
+// política de escalonamento e algoritmo da classe de tempo real (ver
+//   escalonador.h)
+#define POLITICA_ESCALONAMENTO ESC_MLFQ
+#define ALGORITMO_TEMPO_REAL   ESC_TR_EDF
+
+// faixas do histograma de atraso das ativações de tempo real (atraso é o
+//   tempo entre o prazo e o fim da ativação, negativo se terminou antes)
+// a faixa i contém os atrasos até limite_atraso[i]; a última, os maiores
+#define N_FAIXAS_ATRASO 6
+static const int limite_atraso[N_FAIXAS_ATRASO - 1] = { 0, 10, 50, 100, 500 };
+
+// cada processo usa um dos terminais da console, escolhido pelo pid
+// cada terminal ocupa 4 dispositivos no console: leitura do teclado,
+//   estado do teclado, escrita na tela, estado da tela
+#define TERM_TECLADO    0
+#define TERM_TECLADO_OK 1
+#define TERM_TELA       2
+#define TERM_TELA_OK    3
+// o dispositivo 'disp' do terminal 't'
+#define DISP_TERM(t, disp) ((t) * 4 + (disp))
+
+// arquivos onde é gravada a contabilidade dos processos, no final da
+//   execução
+#define ARQ_RELATORIO_CSV  "relatorio.csv"
+#define ARQ_RELATORIO_JSON "relatorio.json"
+
+// maior bloco aceito por SO_LE_BLOCO e SO_ESCR_BLOCO
+#define TAM_MAX_BLOCO_ES 4096
+
+// Cada processo tem sua tabela de páginas e suas páginas na memória
+//   secundária. O programa de um processo é carregado na memória
+//   secundária quando ele é criado, e suas páginas são trazidas para a
+//   memória principal por demanda, quando acontece uma falta de página.
+// Os programas estão sendo todos montados para serem executados no
+//   endereço 0, e o endereço 0 físico é usado pelo hardware nas
+//   interrupções. Os primeiros quadros da memória principal são reservados
+//   para o SO.
+// O processo corrente executa até bloquear, morrer ou terminar seu
+//   quantum; nesse último caso, volta para o final da fila de prontos.
+//   O quantum e a fila dependem da política do escalonador.
+// Os processos de tempo real são periódicos: a cada período são liberados
+//   para executar, e executam antes dos demais até chamarem
+//   SO_ESPERA_PERIODO.
+// Os processos que esperam passar um tempo (em SO_DORME, direto ou no anel
+//   de chamadas, ou esperando o próximo período) ficam no temporizador do
+//   SO, que só custa alguma coisa quando o momento de algum deles chega,
+//   independente de quantos estão esperando. Um canal do relógio é
+//   programado para interromper no próximo tic de quantum, e outro no
+//   próximo evento do temporizador; com a CPU parada, não tem tic de
+//   quantum, e o relógio só interrompe quando chega o momento de algum
+//   evento. Com TIC_DINAMICO, quando o processo corrente é o único que
+//   pode executar, o relógio interrompe só no fim do quantum dele.
+// Um processo que faz E/S em um terminal que não está pronto é bloqueado,
+//   e fica na fila de espera do terminal; a operação é completada (e ele
+//   desbloqueado) no tratamento de pendências, quando o terminal ficar
+//   pronto. A console interrompe quando chegam caracteres no teclado e
+//   quando a fila de saída de um terminal esvazia, e a cada vez o SO
+//   transfere todos os caracteres que puder.
+// Os pedidos colocados nos anéis de chamadas dos processos também são
+//   atendidos no tratamento de pendências.
+
+// fila de processos bloqueados esperando por um dispositivo, encadeada
+//   pelo campo 'prox_espera' dos descritores
+typedef struct {
+  processo_t *primeiro;
+  processo_t *ultimo;
+} so_fila_t;
+
+// tempos dos processos que já terminaram, agrupados pelo programa que
+//   executaram, para o relatório do final da execução
+typedef struct {
+  char *programa;
+  int n_processos;
+  long soma_retorno;    // tempo entre a criação e o fim
+  long soma_resposta;   // tempo entre a criação e a primeira execução
+} so_classe_t;
+
+// contabilidade de um processo que terminou, para o relatório em arquivo
+typedef struct {
+  int pid;
+  char *programa;
+  proc_contas_t contas;
+} so_registro_t;
+
+// totais do sistema, somados da contabilidade de todos os processos
+typedef struct {
+  int n_processos;
+  int n_terminados;
+  long t_executando;
+  long n_preempcoes;
+  long n_faltas_leves;
+  long n_faltas_pesadas;
+} so_totais_t;
 
 struct so_t {
   cpu_t *cpu;
   mem_t *mem;
+  mem_t *mem_sec;
   mmu_t *mmu;
   console_t *console;
   relogio_t *relogio;
-  // quando tiver memória virtual, o controle de memória livre e ocupada
-  //   é mais completo que isso
-  int quadro_livre;
-  // quando tiver processos, não tem essa tabela aqui, tem que tem uma para
-  //   cada processo
-  tabpag_t *tabpag;
+  // tabela de processos
+  processo_t **processos;
+  int n_processos;
+  int cap_processos;
+  int proximo_pid;
+  // processo em execução, ou NULL se a CPU estiver parada
+  processo_t *corrente;
+  escalonador_t *escalonador;
+  // tempos dos processos terminados, por programa
+  so_classe_t *classes;
+  int n_classes;
+  // contabilidade dos processos terminados, na ordem em que terminaram
+  so_registro_t *registros;
+  int n_registros;
+  int cap_registros;
+  // despachos de um processo diferente do último que executou
+  long n_trocas_contexto;
+  int pid_ultimo;
+  // filas de espera de cada terminal, para leitura e para escrita
+  int n_terminais;
+  so_fila_t *espera_le;
+  so_fila_t *espera_escr;
+  // processos com um pedido parado no anel de chamadas, encadeados pelo
+  //   campo 'prox_anel' dos descritores
+  processo_t *aneis_pendentes;
+  // quando deve acontecer o próximo tic de quantum
+  long prox_tic;
+  // número de interrupções atendidas, de cada tipo, e de tics de quantum
+  //   contabilizados, para o relatório
+  long n_irq[N_IRQ];
+  long n_tics;
+  // processos esperando passar um tempo, pelo momento em que desbloqueiam
+  temporizador_t *temporizador;
+  // número de processos de tempo real, e estatística das suas ativações
+  int n_tempo_real;
+  int n_ativacoes_tr;
+  int n_perdas_tr;
+  int hist_atraso[N_FAIXAS_ATRASO];
+  // controle dos quadros da memória principal
+  int n_quadros;
+  // para cada quadro, o processo a quem ele pertence e a página que ele
+  //   contém (-1 se o quadro estiver livre)
+  processo_t **quadro_proc;
+  int *quadro_pagina;
+  // pilha de quadros livres
+  int *quadros_livres;
+  int n_quadros_livres;
+  // próximo quadro a ser substituído (FIFO), se não tiver quadro livre
+  int quadro_vitima;
+  // controle das páginas da memória secundária
+  int n_paginas_sec;
+  // primeira página da memória secundária que ainda não foi usada
+  int pagina_sec_nova;
+  // pilha de páginas da memória secundária liberadas, para reuso
+  int *paginas_sec_livres;
+  int n_paginas_sec_livres;
+  int cap_paginas_sec_livres;
+  // programas já lidos, para não ler de novo a cada criação de processo
+  cacheprog_t *cache_prog;
+  // perfil de execução, ou NULL
+  perfil_t *perfil;
+  // amostrador da execução, ou NULL
+  amostrador_t *amostrador;
+  // contadores de desempenho, ou NULL
+  contadores_t *contadores;
 };
 
 
@@ -40,13 +211,36 @@ struct so_t {
 static err_t so_trata_interrupcao(void *argC, int reg_A);
 
 // funções auxiliares
-static int so_carrega_programa(so_t *self, char *nome_do_executavel);
+static int so_carrega_programa(so_t *self, processo_t *proc,
+                               char *nome_do_executavel);
 static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
-                                     int end_virt/*, processo*/);
+                                     int end_virt, processo_t *proc);
+static bool so_trata_falta_de_pagina(so_t *self, processo_t *proc,
+                                     int end_virt);
+static void so_libera_memoria(so_t *self, processo_t *proc);
+static processo_t *so_cria_processo(so_t *self, char *nome_do_executavel);
+static void so_mata_processo(so_t *self, processo_t *proc);
+static processo_t *so_busca_processo(so_t *self, int pid);
+static void so_bloqueia_processo(so_t *self, processo_t *proc,
+                                 proc_bloqueio_t motivo);
+static void so_desbloqueia_processo(so_t *self, processo_t *proc);
+static void so_contabiliza_fim(so_t *self, processo_t *proc);
+static void so_contabiliza_ativacao(so_t *self, processo_t *proc);
+static void so_programa_relogio(so_t *self);
+static void so_trata_pendencias_es(so_t *self);
+static void so_trata_pendencias_aneis(so_t *self);
+static void so_trata_pendencias_tempo(so_t *self);
+static bool so_le_do_processo(so_t *self, processo_t *proc, int end_virt,
+                              int tam, int valores[tam]);
+static bool so_escreve_no_processo(so_t *self, processo_t *proc, int end_virt,
+                                   int tam, const int valores[tam]);
+static void so_calcula_totais(so_t *self, so_totais_t *tot);
+static void so_imprime_relatorio(so_t *self);
+static void so_grava_relatorio(so_t *self);
 
 
 
-so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu,
+so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_sec, mmu_t *mmu,
               console_t *console, relogio_t *relogio)
 {
   so_t *self = malloc(sizeof(*self));
@@ -54,6 +248,7 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu,
 
   self->cpu = cpu;
   self->mem = mem;
+  self->mem_sec = mem_sec;
   self->mmu = mmu;
   self->console = console;
   self->relogio = relogio;
@@ -74,22 +269,99 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu,
   mem_escreve(self->mem, 11, RETI);
 
   // programa o relógio para gerar uma interrupção após INTERVALO_INTERRUPCAO
-  rel_escr(self->relogio, 2, INTERVALO_INTERRUPCAO);
-
-  // inicializa a tabela de páginas global, e entrega ela para a MMU
-  // com processos, essa tabela não existiria, teria uma por processo
-  self->tabpag = tabpag_cria();
-  mmu_define_tabpag(self->mmu, self->tabpag);
-  // define o primeiro quadro livre de memória como o seguinte àquele que
-  //   contém o endereço 99 (as 100 primeiras posições de memória (pelo menos)
-  //   não vão ser usadas por programas de usuário)
-  self->quadro_livre = 99 / TAM_PAGINA + 1;
+  self->prox_tic = rel_agora(self->relogio) + INTERVALO_INTERRUPCAO;
+  rel_escr(self->relogio, REL_CONTADOR(CANAL_QUANTUM), INTERVALO_INTERRUPCAO);
+
+  // inicializa a tabela de processos
+  // a MMU só recebe uma tabela de páginas quando um processo é despachado
+  self->processos = NULL;
+  self->n_processos = 0;
+  self->cap_processos = 0;
+  self->proximo_pid = 1;
+  self->corrente = NULL;
+  self->escalonador = esc_cria(POLITICA_ESCALONAMENTO, ALGORITMO_TEMPO_REAL);
+  self->temporizador = temp_cria(rel_agora(self->relogio));
+  for (int irq = 0; irq < N_IRQ; irq++) {
+    self->n_irq[irq] = 0;
+  }
+  self->n_tics = 0;
+  self->classes = NULL;
+  self->n_classes = 0;
+  self->registros = NULL;
+  self->n_registros = 0;
+  self->cap_registros = 0;
+  self->n_trocas_contexto = 0;
+  self->pid_ultimo = 0;
+  self->n_terminais = console_n_terminais(self->console);
+  self->espera_le = malloc(self->n_terminais * sizeof(so_fila_t));
+  self->espera_escr = malloc(self->n_terminais * sizeof(so_fila_t));
+  for (int t = 0; t < self->n_terminais; t++) {
+    self->espera_le[t].primeiro = self->espera_le[t].ultimo = NULL;
+    self->espera_escr[t].primeiro = self->espera_escr[t].ultimo = NULL;
+  }
+  self->aneis_pendentes = NULL;
+  self->n_tempo_real = 0;
+  self->n_ativacoes_tr = 0;
+  self->n_perdas_tr = 0;
+  for (int i = 0; i < N_FAIXAS_ATRASO; i++) {
+    self->hist_atraso[i] = 0;
+  }
+
+  // inicializa o controle da memória secundária
+  self->n_paginas_sec = mem_tam(self->mem_sec) / TAM_PAGINA;
+  self->pagina_sec_nova = 0;
+  self->paginas_sec_livres = NULL;
+  self->n_paginas_sec_livres = 0;
+  self->cap_paginas_sec_livres = 0;
+
+  // inicializa o controle de quadros
+  self->n_quadros = mem_tam(self->mem) / TAM_PAGINA;
+  self->quadro_proc = malloc(self->n_quadros * sizeof(processo_t *));
+  self->quadro_pagina = malloc(self->n_quadros * sizeof(int));
+  self->quadros_livres = malloc(self->n_quadros * sizeof(int));
+  self->n_quadros_livres = 0;
+  for (int quadro = self->n_quadros - 1; quadro >= 0; quadro--) {
+    self->quadro_proc[quadro] = NULL;
+    self->quadro_pagina[quadro] = -1;
+    if (quadro >= QUADRO_INI_USUARIO) {
+      self->quadros_livres[self->n_quadros_livres++] = quadro;
+    }
+  }
+  self->quadro_vitima = QUADRO_INI_USUARIO;
+
+  self->cache_prog = cacheprog_cria(TAM_CACHE_PROG);
+  self->perfil = NULL;
+  self->amostrador = NULL;
+  self->contadores = NULL;
   return self;
 }
 
 void so_destroi(so_t *self)
 {
   cpu_define_chamaC(self->cpu, NULL, NULL);
+  mmu_define_tabpag(self->mmu, NULL);
+  so_grava_relatorio(self);
+  for (int i = 0; i < self->n_processos; i++) {
+    proc_destroi(self->processos[i]);
+  }
+  free(self->processos);
+  esc_destroi(self->escalonador);
+  temp_destroi(self->temporizador);
+  for (int i = 0; i < self->n_classes; i++) {
+    free(self->classes[i].programa);
+  }
+  free(self->classes);
+  for (int i = 0; i < self->n_registros; i++) {
+    free(self->registros[i].programa);
+  }
+  free(self->registros);
+  free(self->espera_le);
+  free(self->espera_escr);
+  free(self->quadro_proc);
+  free(self->quadro_pagina);
+  free(self->quadros_livres);
+  free(self->paginas_sec_livres);
+  cacheprog_destroi(self->cache_prog);
   free(self);
 }
 
@@ -100,12 +372,14 @@ void so_destroi(so_t *self)
 static err_t so_trata_irq(so_t *self, int irq);
 static err_t so_trata_irq_reset(so_t *self);
 static err_t so_trata_irq_err_cpu(so_t *self);
-static err_t so_trata_irq_relogio(so_t *self);
+static err_t so_trata_irq_relogio(so_t *self, int canal);
+static err_t so_trata_irq_terminal(so_t *self, int disp_irq);
 static err_t so_trata_irq_desconhecida(so_t *self, int irq);
 static err_t so_trata_chamada_sistema(so_t *self);
 
 // funções auxiliares para o tratamento de interrupção
 static void so_salva_estado_da_cpu(so_t *self);
+static void so_conta_tics(so_t *self);
 static void so_trata_pendencias(so_t *self);
 static void so_escalona(so_t *self);
 static void so_despacha(so_t *self);
@@ -122,9 +396,15 @@ static err_t so_trata_interrupcao(void *argC, int reg_A)
   so_t *self = argC;
   irq_t irq = reg_A;
   err_t err;
+  CRONO_ENTRA(CRONO_SO);
   console_printf(self->console, "SO: recebi IRQ %d (%s)", irq, irq_nome(irq));
+  if (irq >= 0 && irq < N_IRQ) self->n_irq[irq]++;
+  RASTRO_EVENTO(RASTRO_IRQ_ENTRA, rel_agora(self->relogio),
+                self->corrente == NULL ? 0 : self->corrente->pid, irq, 0);
   // salva o estado da cpu no descritor do processo que foi interrompido
   so_salva_estado_da_cpu(self);
+  // desconta do quantum do processo interrompido os tics que passaram
+  so_conta_tics(self);
   // faz o atendimento da interrupção
   err = so_trata_irq(self, irq);
   // faz o processamento independente da interrupção
@@ -133,18 +413,69 @@ static err_t so_trata_interrupcao(void *argC, int reg_A)
   so_escalona(self);
   // recupera o estado do processo escolhido
   so_despacha(self);
+  // programa a próxima interrupção do relógio
+  so_programa_relogio(self);
+  RASTRO_EVENTO(RASTRO_DESPACHO, rel_agora(self->relogio),
+                self->corrente == NULL ? 0 : self->corrente->pid, 0, 0);
+  if (self->perfil != NULL) {
+    perfil_define_programa(self->perfil,
+        self->corrente == NULL ? NULL : self->corrente->programa);
+  }
+  if (self->amostrador != NULL) {
+    if (self->corrente == NULL) {
+      amo_define_processo(self->amostrador, 0, NULL);
+    } else {
+      amo_define_processo(self->amostrador, self->corrente->pid,
+                          self->corrente->programa);
+    }
+  }
+  RASTRO_EVENTO(RASTRO_IRQ_SAI, rel_agora(self->relogio), 0, irq, 0);
+  if (err == ERR_OK && self->n_processos == 0) {
+    console_printf(self->console, "SO: não há mais processos, parando a CPU");
+    so_imprime_relatorio(self);
+    err = ERR_CPU_PARADA;
+  }
+  CRONO_SAI(CRONO_SO);
   return err;
 }
 
 static void so_salva_estado_da_cpu(so_t *self)
 {
   // se não houver processo corrente, não faz nada
+  processo_t *proc = self->corrente;
+  if (proc == NULL) return;
   // salva os registradores que compõem o estado da cpu no descritor do
   //   processo corrente
-  // mem_le(self->mem, IRQ_END_A, endereco onde vai o A no descritor);
-  // mem_le(self->mem, IRQ_END_X, endereco onde vai o X no descritor);
-  // etc
+  int erro, modo;
+  mem_le(self->mem, IRQ_END_PC, &proc->PC);
+  mem_le(self->mem, IRQ_END_A, &proc->A);
+  mem_le(self->mem, IRQ_END_X, &proc->X);
+  mem_le(self->mem, IRQ_END_erro, &erro);
+  mem_le(self->mem, IRQ_END_complemento, &proc->complemento);
+  mem_le(self->mem, IRQ_END_modo, &modo);
+  proc->erro = erro;
+  proc->modo = modo;
 }
+
+// contabiliza os tics de quantum que passaram desde o último
+// com o relógio interrompendo a cada tic, passa no máximo um; com o tic
+//   dinâmico, podem ter passado vários sem interrupção
+static void so_conta_tics(so_t *self)
+{
+  long agora = rel_agora(self->relogio);
+  if (self->corrente == NULL || agora < self->prox_tic) return;
+  int n_tics = (agora - self->prox_tic) / INTERVALO_INTERRUPCAO + 1;
+  self->prox_tic += n_tics * INTERVALO_INTERRUPCAO;
+  self->n_tics += n_tics;
+  // decrementa o quantum do processo corrente; se chegar a zero, o
+  //   escalonador vai colocar ele no final da fila
+  processo_t *proc = self->corrente;
+  proc->quantum = proc->quantum > n_tics ? proc->quantum - n_tics : 0;
+  for (int i = 0; i < n_tics; i++) {
+    esc_tictac(self->escalonador);
+  }
+}
+
 static void so_trata_pendencias(so_t *self)
 {
   // realiza ações que não são diretamente ligadar com a interrupção que
@@ -152,17 +483,121 @@ static void so_trata_pendencias(so_t *self)
   // - E/S pendente
   // - desbloqueio de processos
   // - contabilidades
+  // o desbloqueio de processos que esperam a morte de outro é feito na
+  //   morte; aqui são completadas as operações de E/S dos processos que
+  //   esperam por terminais que ficaram prontos, são desbloqueados os
+  //   processos cujo tempo de espera terminou, e são atendidos os pedidos
+  //   dos anéis de chamadas (depois do tempo, que pode ter terminado um
+  //   SO_DORME do anel)
+  so_trata_pendencias_es(self);
+  so_trata_pendencias_tempo(self);
+  so_trata_pendencias_aneis(self);
+}
+
+// programa o canal do relógio para interromper em 'momento' (-1 para não
+//   interromper)
+static void so_programa_canal(so_t *self, int canal, long momento)
+{
+  int intervalo = 0;
+  if (momento != -1) {
+    long dist = momento - rel_agora(self->relogio);
+    if (dist < 1) dist = 1;
+    if (dist > INT_MAX) dist = INT_MAX;
+    intervalo = dist;
+  }
+  rel_escr(self->relogio, REL_CONTADOR(canal), intervalo);
+}
+
+// programa o relógio para interromper no próximo tic de quantum e no
+//   próximo evento do temporizador, cada um em um canal
+// o tic de quantum só interessa se tiver processo executando; sem processo
+//   o canal dele é desligado, e sem evento o do temporizador
+// com o tic dinâmico, se não tem outro processo pronto, o único tic que
+//   interessa é o último do quantum do processo corrente
+static void so_programa_relogio(so_t *self)
+{
+  long agora = rel_agora(self->relogio);
+  long prox = -1;
+  if (self->corrente != NULL) {
+    // se a CPU estava parada, o tic foi perdido; o quantum começa agora
+    if (self->prox_tic <= agora) {
+      self->prox_tic = agora + INTERVALO_INTERRUPCAO;
+    }
+    prox = self->prox_tic;
+    if (TIC_DINAMICO && esc_vazio(self->escalonador)
+        && self->corrente->quantum > 1) {
+      prox += (long)(self->corrente->quantum - 1) * INTERVALO_INTERRUPCAO;
+    }
+  }
+  so_programa_canal(self, CANAL_QUANTUM, prox);
+  long momento;
+  if (!temp_proximo(self->temporizador, &momento)) momento = -1;
+  so_programa_canal(self, CANAL_TEMPORIZADOR, momento);
 }
+
 static void so_escalona(so_t *self)
 {
   // escolhe o próximo processo a executar, que passa a ser o processo
   //   corrente; pode continuar sendo o mesmo de antes ou não
+  // o processo corrente continua se ainda não terminou seu quantum e não
+  //   tem processo pronto mais prioritário que ele; se terminou, perde
+  //   prioridade e vai para o final da fila de prontos
+  processo_t *proc = self->corrente;
+  long agora = rel_agora(self->relogio);
+  if (proc != NULL) {
+    // contabiliza o tempo de execução desde a última vez
+    esc_executou(self->escalonador, proc, agora - proc->t_despacho);
+    proc->t_despacho = agora;
+  }
+  if (proc != NULL && proc->estado == PROC_EXECUTANDO) {
+    if (proc->quantum > 0) {
+      if (!esc_tem_mais_prioritario(self->escalonador, proc)) return;
+    } else {
+      esc_fim_quantum(self->escalonador, proc);
+    }
+    proc_muda_estado(proc, PROC_PRONTO, agora);
+    proc->contas.n_preempcoes++;
+    esc_insere(self->escalonador, proc);
+  }
+  self->corrente = esc_proximo(self->escalonador);
+  proc = self->corrente;
+  if (proc != NULL) {
+    proc_muda_estado(proc, PROC_EXECUTANDO, agora);
+    proc->quantum = esc_quantum(self->escalonador, proc);
+    proc->t_despacho = agora;
+    proc->contas.n_despachos++;
+    if (proc->contas.t_primeira_exec == -1) {
+      proc->contas.t_primeira_exec = agora;
+    }
+    if (proc->pid != self->pid_ultimo) {
+      self->n_trocas_contexto++;
+      self->pid_ultimo = proc->pid;
+    }
+    console_printf(self->console, "SO: escalonado o processo %d (quantum %d)",
+                   proc->pid, proc->quantum);
+  }
 }
+
 static void so_despacha(so_t *self)
 {
-  // se não houver processo corrente, coloca ERR_CPU_PARADA em IRQ_END_erro
+  // se não houver processo corrente, coloca ERR_CPU_PARADA em IRQ_END_erro,
+  //   e a CPU fica parada (em modo usuário) até a próxima interrupção
   // se houver processo corrente, coloca todo o estado desse processo em
-  //   IRQ_END_*
+  //   IRQ_END_*, e passa a tabela de páginas dele para a MMU
+  processo_t *proc = self->corrente;
+  if (proc == NULL) {
+    mmu_define_tabpag(self->mmu, NULL);
+    mem_escreve(self->mem, IRQ_END_erro, ERR_CPU_PARADA);
+    mem_escreve(self->mem, IRQ_END_modo, usuario);
+    return;
+  }
+  mmu_define_tabpag(self->mmu, proc->tabpag);
+  mem_escreve(self->mem, IRQ_END_PC, proc->PC);
+  mem_escreve(self->mem, IRQ_END_A, proc->A);
+  mem_escreve(self->mem, IRQ_END_X, proc->X);
+  mem_escreve(self->mem, IRQ_END_erro, proc->erro);
+  mem_escreve(self->mem, IRQ_END_complemento, proc->complemento);
+  mem_escreve(self->mem, IRQ_END_modo, proc->modo);
 }
 
 static err_t so_trata_irq(so_t *self, int irq)
@@ -179,7 +614,16 @@ static err_t so_trata_irq(so_t *self, int irq)
       err = so_trata_chamada_sistema(self);
       break;
     case IRQ_RELOGIO:
-      err = so_trata_irq_relogio(self);
+      err = so_trata_irq_relogio(self, CANAL_QUANTUM);
+      break;
+    case IRQ_RELOGIO_1:
+      err = so_trata_irq_relogio(self, CANAL_TEMPORIZADOR);
+      break;
+    case IRQ_TECLADO:
+      err = so_trata_irq_terminal(self, CONSOLE_IRQ_TECLADO);
+      break;
+    case IRQ_TELA:
+      err = so_trata_irq_terminal(self, CONSOLE_IRQ_TELA);
       break;
     default:
       err = so_trata_irq_desconhecida(self, irq);
@@ -189,56 +633,65 @@ static err_t so_trata_irq(so_t *self, int irq)
 
 static err_t so_trata_irq_reset(so_t *self)
 {
-  // coloca o programa "init" na memória
-  // vai programar a tabela de páginas para traduzir os endereços virtuais
-  //   a partir de 0 para o endereço onde ele foi carregado.
-  int ender = so_carrega_programa(self, "init.maq");
-  if (ender < 0) {
+  // cria um processo para executar o programa "init"
+  // o processo é criado com os registradores zerados, exceto o PC e o modo,
+  //   e com as páginas do programa na memória secundária; ele vai ser
+  //   escolhido pelo escalonador e despachado para executar no final do
+  //   tratamento desta interrupção
+  processo_t *init = so_cria_processo(self, "init.maq");
+  if (init == NULL) {
     console_printf(self->console, "SO: problema na carga do programa inicial");
     return ERR_CPU_PARADA;
   }
-
-  // deveria criar um processo para o init, e inicializar o estado do
-  //   processador para esse processo com os registradores zerados, exceto
-  //   o PC e o modo.
-  // como não tem suporte a processos, está carregando os valores dos
-  //   registradores diretamente para a memória, de onde a CPU vai carregar
-  //   para os seus registradores quando executar a instrução RETI
-
-  // altera o PC para o endereço de carga (deve ter sido o endereço virtual 0)
-  mem_escreve(self->mem, IRQ_END_PC, ender);
-  // passa o processador para modo usuário
-  mem_escreve(self->mem, IRQ_END_modo, usuario);
   return ERR_OK;
 }
 
 static err_t so_trata_irq_err_cpu(so_t *self)
 {
   // Ocorreu um erro interno na CPU
-  // O erro está codificado em IRQ_END_erro
+  // O erro está codificado no registrador erro do processo corrente
   // Em geral, causa a morte do processo que causou o erro
-  // Ainda não temos processos, causa a parada da CPU
-  int err_int;
-  // com suporte a processos, deveria pegar o valor do registrador erro
-  //   no descritor do processo corrente, e reagir de acordo com esse erro
-  //   (em geral, matando o processo)
-  mem_le(self->mem, IRQ_END_erro, &err_int);
-  err_t err = err_int;
-  console_printf(self->console,
-      "SO: IRQ não tratada -- erro na CPU: %s", err_nome(err));
-  return ERR_CPU_PARADA;
+  // A exceção é a falta de página, que é atendida, e o processo continua
+  processo_t *proc = self->corrente;
+  if (proc == NULL) {
+    console_printf(self->console, "SO: erro na CPU sem processo corrente");
+    return ERR_CPU_PARADA;
+  }
+  err_t err = proc->erro;
+  if (err == ERR_PAG_AUSENTE || err == ERR_END_INV) {
+    // o endereço que causou a falha está no complemento
+    if (so_trata_falta_de_pagina(self, proc, proc->complemento)) {
+      // a instrução que causou a falta vai ser executada novamente
+      proc->erro = ERR_OK;
+      return ERR_OK;
+    }
+  }
+  console_printf(self->console, "SO: processo %d morto por erro na CPU: %s",
+                 proc->pid, err_nome(err));
+  so_mata_processo(self, proc);
+  return ERR_OK;
+}
+
+static err_t so_trata_irq_relogio(so_t *self, int canal)
+{
+  // ocorreu uma interrupção de um canal do relógio
+  // rearma o interruptor do canal; os canais vão ser reprogramados no
+  //   final do tratamento da interrupção
+  rel_escr(self->relogio, REL_INTERRUPCAO(canal), 0);
+  // os tics de quantum já foram contabilizados (em so_conta_tics), e os
+  //   eventos do temporizador são tratados nas pendências
+  return ERR_OK;
 }
 
-static err_t so_trata_irq_relogio(so_t *self)
+static err_t so_trata_irq_terminal(so_t *self, int disp_irq)
 {
-  // ocorreu uma interrupção do relógio
-  // rearma o interruptor do relógio e reinicializa o timer para a próxima interrupção
-  rel_escr(self->relogio, 3, 0); // desliga o sinalizador de interrupção
-  rel_escr(self->relogio, 2, INTERVALO_INTERRUPCAO);
-  // trata a interrupção
-  // por exemplo, decrementa o quantum do processo corrente, quando se tem
-  // um escalonador com quantum
-  console_printf(self->console, "SO: interrupção do relógio (não tratada)");
+  // chegaram caracteres no teclado ou esvaziou a fila de saída de um ou
+  //   mais terminais
+  // desliga os pedidos de todos os terminais; as operações que estão
+  //   esperando por eles são feitas no tratamento de pendências, que
+  //   verifica todos os terminais (e transfere todos os caracteres que
+  //   puder de cada vez)
+  term_escr(self->console, disp_irq, 0);
   return ERR_OK;
 }
 
@@ -251,135 +704,1448 @@ static err_t so_trata_irq_desconhecida(so_t *self, int irq)
 
 // Chamadas de sistema
 
-static void so_chamada_le(so_t *self);
-static void so_chamada_escr(so_t *self);
-static void so_chamada_cria_proc(so_t *self);
-static void so_chamada_mata_proc(so_t *self);
+static void so_chamada_le(so_t *self, processo_t *proc);
+static void so_chamada_escr(so_t *self, processo_t *proc);
+static void so_chamada_le_bloco(so_t *self, processo_t *proc);
+static void so_chamada_escr_bloco(so_t *self, processo_t *proc);
+static void so_chamada_cria_proc(so_t *self, processo_t *proc);
+static void so_chamada_mata_proc(so_t *self, processo_t *proc);
+static void so_chamada_espera_proc(so_t *self, processo_t *proc);
+static void so_chamada_nice(so_t *self, processo_t *proc);
+static void so_chamada_dorme(so_t *self, processo_t *proc);
+static void so_chamada_contador(so_t *self, processo_t *proc);
+static void so_chamada_contador_cmd(so_t *self, processo_t *proc);
+static void so_chamada_tempo_real(so_t *self, processo_t *proc);
+static void so_chamada_espera_periodo(so_t *self, processo_t *proc);
+static void so_chamada_anel_registra(so_t *self, processo_t *proc);
+static void so_chamada_anel_entra(so_t *self, processo_t *proc);
 
 static err_t so_trata_chamada_sistema(so_t *self)
 {
-  // com processos, a identificação da chamada está no reg A no descritor
-  //   do processo
-  int id_chamada;
-  mem_le(self->mem, IRQ_END_A, &id_chamada);
+  // a identificação da chamada está no reg A no descritor do processo
+  processo_t *proc = self->corrente;
+  if (proc == NULL) {
+    console_printf(self->console, "SO: chamada de sistema sem processo");
+    return ERR_CPU_PARADA;
+  }
+  int id_chamada = proc->A;
   console_printf(self->console,
-      "SO: chamada de sistema %d", id_chamada);
+      "SO: chamada de sistema %d do processo %d", id_chamada, proc->pid);
+  RASTRO_EVENTO(RASTRO_CHAMADA, rel_agora(self->relogio), proc->pid,
+                id_chamada, 0);
+  if (id_chamada >= 0 && id_chamada < PROC_N_CHAMADAS) {
+    proc->contas.n_chamadas[id_chamada]++;
+  } else {
+    proc->contas.n_chamadas[PROC_N_CHAMADAS - 1]++;
+  }
   switch (id_chamada) {
     case SO_LE:
-      so_chamada_le(self);
+      so_chamada_le(self, proc);
       break;
     case SO_ESCR:
-      so_chamada_escr(self);
+      so_chamada_escr(self, proc);
+      break;
+    case SO_LE_BLOCO:
+      so_chamada_le_bloco(self, proc);
+      break;
+    case SO_ESCR_BLOCO:
+      so_chamada_escr_bloco(self, proc);
       break;
     case SO_CRIA_PROC:
-      so_chamada_cria_proc(self);
+      so_chamada_cria_proc(self, proc);
       break;
     case SO_MATA_PROC:
-      so_chamada_mata_proc(self);
+      so_chamada_mata_proc(self, proc);
+      break;
+    case SO_ESPERA_PROC:
+      so_chamada_espera_proc(self, proc);
+      break;
+    case SO_NICE:
+      so_chamada_nice(self, proc);
+      break;
+    case SO_DORME:
+      so_chamada_dorme(self, proc);
+      break;
+    case SO_CONTADOR:
+      so_chamada_contador(self, proc);
+      break;
+    case SO_CONTADOR_CMD:
+      so_chamada_contador_cmd(self, proc);
+      break;
+    case SO_TEMPO_REAL:
+      so_chamada_tempo_real(self, proc);
+      break;
+    case SO_ESPERA_PERIODO:
+      so_chamada_espera_periodo(self, proc);
+      break;
+    case SO_ANEL_REGISTRA:
+      so_chamada_anel_registra(self, proc);
+      break;
+    case SO_ANEL_ENTRA:
+      so_chamada_anel_entra(self, proc);
       break;
     default:
       console_printf(self->console,
-          "SO: chamada de sistema desconhecida (%d)", id_chamada);
-      return ERR_CPU_PARADA;
+          "SO: chamada de sistema desconhecida (%d), processo %d morto",
+          id_chamada, proc->pid);
+      so_mata_processo(self, proc);
   }
   return ERR_OK;
 }
 
-static void so_chamada_le(so_t *self)
-{
-  // implementação com espera ocupada
-  //   deveria bloquear o processo se leitura não disponível.
-  //   no caso de bloqueio do processo, a leitura (e desbloqueio) deverá
-  //   ser feita mais tarde, em tratamentos pendentes em outra interrupção,
-  //   ou diretamente em uma interrupção específica do dispositivo, se for
-  //   o caso
-  // implementação lendo direto do terminal A
-  //   deveria usar dispositivo corrente de entrada do processo
-  for (;;) {
-    int estado;
-    term_le(self->console, 1, &estado);
-    if (estado != 0) break;
-    // como não está saindo do SO, o laço do processador não tá rodando
-    // esta gambiarra faz o console andar
-    // com a implementação de bloqueio de processo, esta gambiarra não
-    //   deve mais existir.
-    console_tictac(self->console);
-    console_atualiza(self->console);
-  }
-  int dado;
-  term_le(self->console, 0, &dado);
-  // com processo, deveria escrever no reg A do processo
-  mem_escreve(self->mem, IRQ_END_A, dado);
-}
-
-static void so_chamada_escr(so_t *self)
-{
-  // implementação com espera ocupada
-  //   deveria bloquear o processo se dispositivo ocupado
-  // implementação escrevendo direto do terminal A
-  //   deveria usar dispositivo corrente de saída do processo
-  for (;;) {
-    int estado;
-    term_le(self->console, 3, &estado);
-    if (estado != 0) break;
-    // como não está saindo do SO, o laço do processador não tá rodando
-    // esta gambiarra faz o console andar
-    console_tictac(self->console);
-    console_atualiza(self->console);
-  }
-  int dado;
-  mem_le(self->mem, IRQ_END_X, &dado);
-  term_escr(self->console, 2, dado);
-  mem_escreve(self->mem, IRQ_END_A, 0);
-}
-
-static void so_chamada_cria_proc(so_t *self)
-{
-  // ainda sem suporte a processos, carrega programa e passa a executar ele
-  // quem chamou o sistema não vai mais ser executado, coitado!
+// Entrada e saída nos terminais
+// As operações são feitas na hora se o terminal estiver pronto e não tiver
+//   outros processos esperando por ele; senão o processo é colocado na
+//   fila de espera do terminal e bloqueado.
 
+// retorna true se o dispositivo do terminal está pronto
+static bool so_term_pronto(so_t *self, int terminal, int disp_ok)
+{
+  int estado;
+  if (term_le(self->console, DISP_TERM(terminal, disp_ok), &estado) != ERR_OK) {
+    return false;
+  }
+  return estado != 0;
+}
+
+// lê para a operação de leitura do processo os caracteres disponíveis no
+//   teclado
+// retorna true se a operação foi completada: leu todos os caracteres
+//   pedidos ou, se for um bloco, leu pelo menos um e não tem mais
+//   disponível; nesse caso o resultado está no A do processo
+static bool so_avanca_le(so_t *self, processo_t *proc)
+{
+  while (proc->es_feitos < proc->es_tam
+         && so_term_pronto(self, proc->terminal, TERM_TECLADO_OK)) {
+    int dado;
+    term_le(self->console, DISP_TERM(proc->terminal, TERM_TECLADO), &dado);
+    if (proc->es_dados == NULL) {
+      proc->A = dado;
+    } else {
+      proc->es_dados[proc->es_feitos] = dado;
+    }
+    proc->es_feitos++;
+  }
+  if (proc->es_feitos == 0) return false;
+  if (proc->es_dados != NULL) {
+    // coloca os caracteres lidos na memória do processo, de uma vez
+    if (so_escreve_no_processo(self, proc, proc->es_end,
+                               proc->es_feitos, proc->es_dados)) {
+      proc->A = proc->es_feitos;
+    } else {
+      proc->A = -1;
+    }
+    free(proc->es_dados);
+    proc->es_dados = NULL;
+  }
+  return true;
+}
+
+// escreve na tela os caracteres da operação de escrita do processo, até
+//   a tela ficar ocupada
+// retorna true se a operação foi completada; nesse caso o resultado está
+//   no A do processo
+static bool so_avanca_escr(so_t *self, processo_t *proc)
+{
+  while (proc->es_feitos < proc->es_tam
+         && so_term_pronto(self, proc->terminal, TERM_TELA_OK)) {
+    int dado = proc->es_dados == NULL ? proc->X
+                                      : proc->es_dados[proc->es_feitos];
+    term_escr(self->console, DISP_TERM(proc->terminal, TERM_TELA), dado);
+    proc->es_feitos++;
+  }
+  if (proc->es_feitos < proc->es_tam) return false;
+  if (proc->es_dados == NULL) {
+    proc->A = 0;
+  } else {
+    proc->A = proc->es_tam;
+    free(proc->es_dados);
+    proc->es_dados = NULL;
+  }
+  return true;
+}
+
+// inicia a operação de E/S do processo, de 'tam' caracteres; 'dados' é o
+//   bloco (alocado com malloc, passa a pertencer ao processo), ou NULL se
+//   for um só caractere
+static void so_inicia_es(processo_t *proc, int *dados, int tam, int end)
+{
+  proc->es_dados = dados;
+  proc->es_tam = tam;
+  proc->es_feitos = 0;
+  proc->es_end = end;
+}
+
+static void so_fila_insere(so_fila_t *fila, processo_t *proc)
+{
+  proc->prox_espera = NULL;
+  if (fila->ultimo == NULL) {
+    fila->primeiro = proc;
+  } else {
+    fila->ultimo->prox_espera = proc;
+  }
+  fila->ultimo = proc;
+}
+
+static processo_t *so_fila_retira(so_fila_t *fila)
+{
+  processo_t *proc = fila->primeiro;
+  if (proc == NULL) return NULL;
+  fila->primeiro = proc->prox_espera;
+  if (fila->primeiro == NULL) fila->ultimo = NULL;
+  proc->prox_espera = NULL;
+  return proc;
+}
+
+// remove o processo da fila, esteja onde estiver (para quando um processo
+//   bloqueado é morto)
+static void so_fila_remove(so_fila_t *fila, processo_t *proc)
+{
+  processo_t *ant = NULL;
+  for (processo_t *p = fila->primeiro; p != NULL; p = p->prox_espera) {
+    if (p == proc) {
+      if (ant == NULL) {
+        fila->primeiro = p->prox_espera;
+      } else {
+        ant->prox_espera = p->prox_espera;
+      }
+      if (fila->ultimo == p) fila->ultimo = ant;
+      p->prox_espera = NULL;
+      return;
+    }
+    ant = p;
+  }
+}
+
+// avança as operações de E/S que estão esperando por terminais que
+//   ficaram prontos, na ordem em que foram pedidas, e desbloqueia os
+//   processos cujas operações foram completadas
+static void so_trata_pendencias_es(so_t *self)
+{
+  for (int t = 0; t < self->n_terminais; t++) {
+    while (self->espera_le[t].primeiro != NULL
+           && so_avanca_le(self, self->espera_le[t].primeiro)) {
+      so_desbloqueia_processo(self, so_fila_retira(&self->espera_le[t]));
+    }
+    while (self->espera_escr[t].primeiro != NULL
+           && so_avanca_escr(self, self->espera_escr[t].primeiro)) {
+      so_desbloqueia_processo(self, so_fila_retira(&self->espera_escr[t]));
+    }
+  }
+}
+
+// realiza o que for possível da operação de leitura do processo; se não
+//   completar, o processo é bloqueado na fila do terminal, e a operação
+//   continua no tratamento de pendências
+static void so_le(so_t *self, processo_t *proc)
+{
+  so_fila_t *fila = &self->espera_le[proc->terminal];
+  if (fila->primeiro == NULL && so_avanca_le(self, proc)) return;
+  so_fila_insere(fila, proc);
+  so_bloqueia_processo(self, proc, BLOQ_LE);
+}
+
+// idem, para escrita
+static void so_escr(so_t *self, processo_t *proc)
+{
+  so_fila_t *fila = &self->espera_escr[proc->terminal];
+  if (fila->primeiro == NULL && so_avanca_escr(self, proc)) return;
+  so_fila_insere(fila, proc);
+  so_bloqueia_processo(self, proc, BLOQ_ESCR);
+}
+
+// lê os parâmetros de SO_LE_BLOCO e SO_ESCR_BLOCO (endereço e tamanho do
+//   bloco) e aloca o bloco
+// retorna false se os parâmetros forem inválidos
+static bool so_pega_bloco_es(so_t *self, processo_t *proc,
+                             int *pend, int *ptam, int **pdados)
+{
+  int param[2];
+  if (!so_le_do_processo(self, proc, proc->X, 2, param)) return false;
+  *pend = param[0];
+  *ptam = param[1];
+  if (*pend < 0 || *ptam < 0 || *ptam > TAM_MAX_BLOCO_ES) return false;
+  *pdados = malloc((*ptam > 0 ? *ptam : 1) * sizeof(int));
+  return *pdados != NULL;
+}
+
+static void so_chamada_le(so_t *self, processo_t *proc)
+{
+  // lê um caractere do terminal do processo, que é retornado em A
+  // se não tiver caractere disponível, bloqueia o processo
+  so_inicia_es(proc, NULL, 1, 0);
+  so_le(self, proc);
+}
+
+static void so_chamada_escr(so_t *self, processo_t *proc)
+{
+  // escreve o caractere em X no terminal do processo
+  // se a tela estiver ocupada, bloqueia o processo
+  so_inicia_es(proc, NULL, 1, 0);
+  so_escr(self, proc);
+}
+
+static void so_chamada_le_bloco(so_t *self, processo_t *proc)
+{
+  // lê para a memória do processo os caracteres disponíveis no terminal,
+  //   até o máximo pedido; bloqueia o processo se não tiver nenhum
+  int end, tam, *dados;
+  if (!so_pega_bloco_es(self, proc, &end, &tam, &dados)) {
+    proc->A = -1;
+    return;
+  }
+  if (tam == 0) {
+    free(dados);
+    proc->A = 0;
+    return;
+  }
+  so_inicia_es(proc, dados, tam, end);
+  so_le(self, proc);
+}
+
+static void so_chamada_escr_bloco(so_t *self, processo_t *proc)
+{
+  // escreve no terminal os caracteres da memória do processo; o bloco é
+  //   copiado de uma vez, e o processo fica bloqueado até que todos os
+  //   caracteres tenham sido escritos
+  int end, tam, *dados;
+  if (!so_pega_bloco_es(self, proc, &end, &tam, &dados)) {
+    proc->A = -1;
+    return;
+  }
+  if (!so_le_do_processo(self, proc, end, tam, dados)) {
+    free(dados);
+    proc->A = -1;
+    return;
+  }
+  so_inicia_es(proc, dados, tam, end);
+  so_escr(self, proc);
+}
+
+static void so_chamada_cria_proc(so_t *self, processo_t *proc)
+{
   // em X está o endereço onde está o nome do arquivo
-  int ender_proc;
-  // deveria ler o X do descritor do processo criador
-  if (mem_le(self->mem, IRQ_END_X, &ender_proc) == ERR_OK) {
-    char nome[100];
-    if (so_copia_str_do_processo(self, 100, nome, ender_proc)) {
-      int ender_carga = so_carrega_programa(self, nome);
-      // o endereço de carga é endereço virtual, deve ser 0
-      if (ender_carga >= 0) {
-        // deveria escrever no PC do descritor do processo criado
-        mem_escreve(self->mem, IRQ_END_PC, ender_carga);
-        return;
+  // retorna em A o pid do processo criado, ou -1 se erro
+  char nome[100];
+  if (so_copia_str_do_processo(self, 100, nome, proc->X, proc)) {
+    processo_t *novo = so_cria_processo(self, nome);
+    if (novo != NULL) {
+      proc->A = novo->pid;
+      return;
+    }
+  }
+  proc->A = -1;
+}
+
+static void so_chamada_mata_proc(so_t *self, processo_t *proc)
+{
+  // em X está o pid do processo a matar, ou 0 para o próprio processo
+  // retorna em A 0 se OK ou -1 se o processo não existe
+  int pid = proc->X;
+  processo_t *vitima = pid == 0 ? proc : so_busca_processo(self, pid);
+  if (vitima == NULL) {
+    proc->A = -1;
+    return;
+  }
+  proc->A = 0;
+  so_mata_processo(self, vitima);
+}
+
+static void so_chamada_espera_proc(so_t *self, processo_t *proc)
+{
+  // em X está o pid do processo a esperar
+  // retorna em A 0 se OK ou -1 se o processo não existe (ou é o próprio
+  //   processo, que ia esperar para sempre)
+  int pid = proc->X;
+  processo_t *esperado = so_busca_processo(self, pid);
+  if (esperado == NULL || esperado == proc) {
+    proc->A = -1;
+    return;
+  }
+  proc->A = 0;
+  proc->espera_pid = pid;
+  so_bloqueia_processo(self, proc, BLOQ_ESPERA_PROC);
+}
+
+static void so_chamada_nice(so_t *self, processo_t *proc)
+{
+  // em X está o novo valor de nice do processo
+  // retorna em A 0 se OK ou -1 se o valor está fora dos limites
+  // o processo está executando, não está nas estruturas do escalonador;
+  //   o novo peso vale a partir da próxima contabilização
+  int nice = proc->X;
+  if (nice < NICE_MIN || nice > NICE_MAX) {
+    proc->A = -1;
+    return;
+  }
+  console_printf(self->console, "SO: nice do processo %d: %d -> %d",
+                 proc->pid, proc->nice, nice);
+  proc->nice = nice;
+  proc->A = 0;
+}
+
+static void so_chamada_dorme(so_t *self, processo_t *proc)
+{
+  // em X está o tempo que o processo quer esperar
+  // o processo fica no temporizador até o momento de acordar; ele é
+  //   desbloqueado no tratamento de pendências
+  proc->A = 0;
+  if (proc->X <= 0) return;
+  temp_insere(self->temporizador, &proc->desperta,
+              rel_agora(self->relogio) + proc->X, proc);
+  so_bloqueia_processo(self, proc, BLOQ_DORME);
+}
+
+static void so_chamada_contador(so_t *self, processo_t *proc)
+{
+  // em X está o número do contador
+  long valor;
+  if (self->contadores == NULL
+      || !cont_valor(self->contadores, proc->X, &valor)) {
+    proc->A = -1;
+    return;
+  }
+  proc->A = (int)valor;
+}
+
+static void so_chamada_contador_cmd(so_t *self, processo_t *proc)
+{
+  // em X está o comando
+  if (self->contadores == NULL
+      || !cont_comando(self->contadores, proc->X)) {
+    proc->A = -1;
+    return;
+  }
+  proc->A = 0;
+}
+
+static void so_chamada_tempo_real(so_t *self, processo_t *proc)
+{
+  // em X está o endereço, na memória do processo, de 3 valores: período,
+  //   wcet e prazo (0 para prazo igual ao período)
+  // retorna em A 0 se o processo foi admitido na classe de tempo real, ou
+  //   -1 se não foi (parâmetros inválidos ou utilização excessiva)
+  int param[3];
+  if (!so_le_do_processo(self, proc, proc->X, 3, param)) {
+    proc->A = -1;
+    return;
+  }
+  // os parâmetros só vão para o descritor se o processo for admitido (um
+  //   processo já admitido não pode ter os seus trocados)
+  int periodo = param[0];
+  int wcet = param[1];
+  int prazo = param[2] == 0 ? param[0] : param[2];
+  if (!esc_admite_tempo_real(self->escalonador, proc, periodo, wcet, prazo)) {
+    console_printf(self->console,
+        "SO: processo %d não admitido em tempo real (P=%d C=%d D=%d)",
+        proc->pid, periodo, wcet, prazo);
+    proc->A = -1;
+    return;
+  }
+  console_printf(self->console,
+      "SO: processo %d em tempo real (%s, P=%d C=%d D=%d)", proc->pid,
+      esc_nome_tempo_real(self->escalonador),
+      proc->periodo, proc->wcet, proc->prazo);
+  self->n_tempo_real++;
+  // a primeira ativação começa agora
+  proc->liberacao = rel_agora(self->relogio);
+  proc->prazo_abs = proc->liberacao + proc->prazo;
+  proc->n_ativacoes = 1;
+  proc->A = 0;
+}
+
+static void so_chamada_espera_periodo(so_t *self, processo_t *proc)
+{
+  // termina a ativação corrente do processo de tempo real, e bloqueia ele
+  //   até o início do próximo período
+  // se o próximo período já começou, não bloqueia
+  // retorna em A 0 se OK ou -1 se o processo não é de tempo real
+  if (!proc->tempo_real) {
+    proc->A = -1;
+    return;
+  }
+  proc->A = 0;
+  so_contabiliza_ativacao(self, proc);
+  proc->liberacao += proc->periodo;
+  if (proc->liberacao <= rel_agora(self->relogio)) {
+    proc->prazo_abs = proc->liberacao + proc->prazo;
+    proc->n_ativacoes++;
+    return;
+  }
+  temp_insere(self->temporizador, &proc->desperta, proc->liberacao, proc);
+  so_bloqueia_processo(self, proc, BLOQ_PERIODO);
+}
+
+// desbloqueia os processos cujo momento de acordar chegou
+// os processos de tempo real começam uma nova ativação
+static void so_trata_pendencias_tempo(so_t *self)
+{
+  temp_no_t *no = temp_avanca(self->temporizador, rel_agora(self->relogio));
+  while (no != NULL) {
+    processo_t *proc = no->dado;
+    bool do_anel = no == &proc->anel_desperta;
+    no = no->prox;
+    if (do_anel) {
+      // o anel continua no tratamento de pendências dos anéis
+      proc->anel_acordou = true;
+      continue;
+    }
+    if (proc->bloqueio == BLOQ_PERIODO) {
+      proc->prazo_abs = proc->liberacao + proc->prazo;
+      proc->n_ativacoes++;
+    }
+    so_desbloqueia_processo(self, proc);
+  }
+}
+
+
+// Anel de chamadas
+
+// verifica se um pedido do anel do processo já pode ser atendido
+// a E/S do anel só é feita se não tiver processo na fila de espera do
+//   terminal, para não passar na frente das chamadas de sistema
+static bool so_pedido_pronto(so_t *self, processo_t *proc, int op, int arg)
+{
+  int t = proc->terminal;
+  switch (op) {
+    case SO_LE:
+      return self->espera_le[t].primeiro == NULL
+             && so_term_pronto(self, t, TERM_TECLADO_OK);
+    case SO_ESCR:
+      return self->espera_escr[t].primeiro == NULL
+             && so_term_pronto(self, t, TERM_TELA_OK);
+    case SO_ESPERA_PROC:
+      return arg == proc->pid || so_busca_processo(self, arg) == NULL;
+    case SO_DORME:
+      return arg <= 0 || proc->anel_acordou;
+    default:
+      return true;
+  }
+}
+
+// executa um pedido do anel do processo, colocando o resultado em *pres
+// retorna false se o pedido ainda não pode ser atendido
+static bool so_executa_pedido(so_t *self, processo_t *proc,
+                              int op, int arg, int *pres)
+{
+  if (!so_pedido_pronto(self, proc, op, arg)) {
+    // o tempo do SO_DORME começa a contar quando chega a vez do pedido; o
+    //   anel fica parado nele até o evento acontecer
+    if (op == SO_DORME && !proc->anel_desperta.ativo) {
+      temp_insere(self->temporizador, &proc->anel_desperta,
+                  rel_agora(self->relogio) + arg, proc);
+    }
+    return false;
+  }
+  int t = proc->terminal;
+  switch (op) {
+    case SO_LE:
+      term_le(self->console, DISP_TERM(t, TERM_TECLADO), pres);
+      return true;
+    case SO_ESCR:
+      term_escr(self->console, DISP_TERM(t, TERM_TELA), arg);
+      *pres = 0;
+      return true;
+    case SO_ESPERA_PROC:
+      *pres = arg == proc->pid ? -1 : 0;
+      return true;
+    case SO_DORME:
+      proc->anel_acordou = false;
+      *pres = 0;
+      return true;
+    default:
+      *pres = -1;
+      return true;
+  }
+}
+
+// atende os pedidos do anel do processo que puderem ser atendidos, em
+//   ordem, colocando os resultados no anel de completamento
+// se um pedido não puder ser atendido, ele fica em anel_op e anel_arg
+// retorna o número de completamentos disponíveis para o processo, ou -1
+//   se o anel for inválido (nesse caso, ele é desregistrado)
+static int so_avanca_anel(so_t *self, processo_t *proc)
+{
+  proc->anel_op = -1;
+  int end = proc->anel_end;
+  int n = proc->anel_n;
+  int end_compl = end + ANEL_PEDIDOS + n * ANEL_TAM_PEDIDO;
+  int cab[ANEL_PEDIDOS];
+  if (!so_le_do_processo(self, proc, end, ANEL_PEDIDOS, cab)) goto invalido;
+  int n_sub = cab[ANEL_SUB_CAUDA] - cab[ANEL_SUB_CABECA];
+  int n_compl = cab[ANEL_COMP_CAUDA] - cab[ANEL_COMP_CABECA];
+  if (cab[ANEL_SUB_CABECA] < 0 || cab[ANEL_COMP_CABECA] < 0
+      || n_sub < 0 || n_sub > n || n_compl < 0 || n_compl > n) {
+    goto invalido;
+  }
+  int atendidos = 0;
+  while (atendidos < n_sub && n_compl < n) {
+    int i = (cab[ANEL_SUB_CABECA] + atendidos) % n;
+    int pedido[ANEL_TAM_PEDIDO];
+    if (!so_le_do_processo(self, proc, end + ANEL_PEDIDOS
+                           + i * ANEL_TAM_PEDIDO, ANEL_TAM_PEDIDO, pedido)) {
+      goto invalido;
+    }
+    int compl[ANEL_TAM_COMPL] = { pedido[2], 0 };
+    if (!so_executa_pedido(self, proc, pedido[0], pedido[1], &compl[1])) {
+      proc->anel_op = pedido[0];
+      proc->anel_arg = pedido[1];
+      break;
+    }
+    i = cab[ANEL_COMP_CAUDA] % n;
+    if (!so_escreve_no_processo(self, proc, end_compl + i * ANEL_TAM_COMPL,
+                                ANEL_TAM_COMPL, compl)) {
+      goto invalido;
+    }
+    cab[ANEL_COMP_CAUDA]++;
+    n_compl++;
+    atendidos++;
+  }
+  if (atendidos > 0) {
+    cab[ANEL_SUB_CABECA] += atendidos;
+    // o processo não executa enquanto o SO executa, não tem como ele ter
+    //   alterado os outros contadores
+    if (!so_escreve_no_processo(self, proc, end, ANEL_PEDIDOS, cab)) {
+      goto invalido;
+    }
+  }
+  return n_compl;
+invalido:
+  console_printf(self->console, "SO: anel do processo %d inválido",
+                 proc->pid);
+  proc->anel_end = -1;
+  proc->anel_op = -1;
+  temp_remove(self->temporizador, &proc->anel_desperta);
+  return -1;
+}
+
+// coloca o processo na lista de anéis pendentes, se o anel dele parou em
+//   um pedido
+static void so_marca_anel(so_t *self, processo_t *proc)
+{
+  if (proc->anel_op == -1 || proc->anel_pendente) return;
+  proc->prox_anel = self->aneis_pendentes;
+  self->aneis_pendentes = proc;
+  proc->anel_pendente = true;
+}
+
+// tira o processo da lista de anéis pendentes (para quando ele morre)
+static void so_desmarca_anel(so_t *self, processo_t *proc)
+{
+  if (!proc->anel_pendente) return;
+  processo_t **pp = &self->aneis_pendentes;
+  while (*pp != proc) pp = &(*pp)->prox_anel;
+  *pp = proc->prox_anel;
+  proc->prox_anel = NULL;
+  proc->anel_pendente = false;
+}
+
+// continua os anéis que pararam em um pedido que agora pode ser atendido,
+//   e desbloqueia os processos que estão esperando completamentos que já
+//   existem
+// só os anéis da lista de pendentes são vistos, e a memória do processo só
+//   é acessada quando o pedido parado ficou pronto; os anéis sem pedido
+//   parado só são vistos de novo na próxima SO_ANEL_ENTRA
+static void so_trata_pendencias_aneis(so_t *self)
+{
+  processo_t **pp = &self->aneis_pendentes;
+  while (*pp != NULL) {
+    processo_t *proc = *pp;
+    if (proc->anel_end != -1 && proc->anel_op != -1) {
+      if (!so_pedido_pronto(self, proc, proc->anel_op, proc->anel_arg)) {
+        pp = &proc->prox_anel;
+        continue;
       }
+      int n_compl = so_avanca_anel(self, proc);
+      // sem pedido parado, o processo não espera mais (como em
+      //   so_chamada_anel_entra)
+      if (proc->estado == PROC_BLOQUEADO && proc->bloqueio == BLOQ_ANEL
+          && (n_compl < 0 || n_compl >= proc->anel_espera
+              || proc->anel_op == -1)) {
+        proc->A = n_compl;
+        so_desbloqueia_processo(self, proc);
+      }
+      if (proc->anel_op != -1) {
+        pp = &proc->prox_anel;
+        continue;
+      }
+    }
+    // o anel não está mais parado
+    *pp = proc->prox_anel;
+    proc->prox_anel = NULL;
+    proc->anel_pendente = false;
+  }
+}
+
+static void so_chamada_anel_registra(so_t *self, processo_t *proc)
+{
+  // em X está o endereço do anel na memória do processo, ou -1
+  // retorna em A 0 se OK ou -1 se o anel é inválido
+  proc->anel_end = -1;
+  proc->anel_op = -1;
+  temp_remove(self->temporizador, &proc->anel_desperta);
+  proc->anel_acordou = false;
+  proc->A = 0;
+  if (proc->X == -1) return;
+  int n;
+  if (!so_le_do_processo(self, proc, proc->X + ANEL_N, 1, &n)
+      || n < 1 || n > ANEL_MAX) {
+    proc->A = -1;
+    return;
+  }
+  proc->anel_end = proc->X;
+  proc->anel_n = n;
+  // já verifica os contadores e atende o que tiver
+  if (so_avanca_anel(self, proc) < 0) proc->A = -1;
+  so_marca_anel(self, proc);
+}
+
+static void so_chamada_anel_entra(so_t *self, processo_t *proc)
+{
+  // em X está o número de completamentos a esperar
+  // retorna em A o número de completamentos disponíveis ou -1 se o
+  //   processo não tem anel válido ou espera mais do que cabe no anel
+  if (proc->anel_end == -1 || proc->X > proc->anel_n) {
+    proc->A = -1;
+    return;
+  }
+  int n_compl = so_avanca_anel(self, proc);
+  so_marca_anel(self, proc);
+  proc->A = n_compl;
+  if (n_compl < 0 || n_compl >= proc->X) return;
+  // sem pedido parado, não tem o que gere mais completamentos; bloquear
+  //   seria para sempre
+  if (proc->anel_op == -1) return;
+  proc->anel_espera = proc->X;
+  so_bloqueia_processo(self, proc, BLOQ_ANEL);
+}
+
+
+// Gerência de processos
+
+// cria um processo para executar o programa, e coloca ele na fila de
+//   prontos
+// retorna o descritor do processo, ou NULL se não foi possível criar
+static processo_t *so_cria_processo(so_t *self, char *nome_do_executavel)
+{
+  if (self->n_processos == self->cap_processos) {
+    int cap = self->cap_processos * 2 + 10;
+    processo_t **p = realloc(self->processos, cap * sizeof(processo_t *));
+    if (p == NULL) return NULL;
+    self->processos = p;
+    self->cap_processos = cap;
+  }
+  processo_t *proc = proc_cria(self->proximo_pid, nome_do_executavel);
+  if (proc == NULL) return NULL;
+  int ender = so_carrega_programa(self, proc, nome_do_executavel);
+  if (ender < 0) {
+    proc_destroi(proc);
+    return NULL;
+  }
+  self->proximo_pid++;
+  proc->PC = ender;
+  proc->terminal = (proc->pid - 1) % self->n_terminais;
+  proc->contas.t_criacao = rel_agora(self->relogio);
+  proc->contas.t_estado = proc->contas.t_criacao;
+  self->processos[self->n_processos++] = proc;
+  esc_insere(self->escalonador, proc);
+  RASTRO_EVENTO(RASTRO_PROC_CRIA, rel_agora(self->relogio), proc->pid, 0, 0);
+  console_printf(self->console, "SO: criado o processo %d ('%s')",
+                 proc->pid, nome_do_executavel);
+  return proc;
+}
+
+// mata o processo: libera a memória que ele ocupa, desbloqueia quem
+//   estiver esperando por ele e destrói o descritor
+static void so_mata_processo(so_t *self, processo_t *proc)
+{
+  console_printf(self->console, "SO: fim do processo %d", proc->pid);
+  RASTRO_EVENTO(RASTRO_PROC_FIM, rel_agora(self->relogio), proc->pid, 0, 0);
+  so_contabiliza_fim(self, proc);
+  so_libera_memoria(self, proc);
+  if (proc->estado == PROC_PRONTO) {
+    esc_remove(self->escalonador, proc);
+  } else if (proc->estado == PROC_BLOQUEADO && proc->bloqueio == BLOQ_LE) {
+    so_fila_remove(&self->espera_le[proc->terminal], proc);
+  } else if (proc->estado == PROC_BLOQUEADO && proc->bloqueio == BLOQ_ESCR) {
+    so_fila_remove(&self->espera_escr[proc->terminal], proc);
+  }
+  temp_remove(self->temporizador, &proc->desperta);
+  temp_remove(self->temporizador, &proc->anel_desperta);
+  so_desmarca_anel(self, proc);
+  if (proc->tempo_real) {
+    console_printf(self->console,
+        "SO: processo %d: %d ativações, %d prazos perdidos",
+        proc->pid, proc->n_ativacoes, proc->n_perdas);
+    esc_libera_tempo_real(self->escalonador, proc);
+    self->n_tempo_real--;
+  }
+  int i_proc = -1;
+  for (int i = 0; i < self->n_processos; i++) {
+    processo_t *p = self->processos[i];
+    if (p == proc) {
+      i_proc = i;
+    } else if (p->estado == PROC_BLOQUEADO && p->bloqueio == BLOQ_ESPERA_PROC
+               && p->espera_pid == proc->pid) {
+      so_desbloqueia_processo(self, p);
     }
   }
-  // deveria escrever -1 (se erro) ou o PID do processo criado (se OK) no reg A
-  //   do processo que pediu a criação
-  mem_escreve(self->mem, IRQ_END_A, -1);
+  if (i_proc != -1) {
+    self->processos[i_proc] = self->processos[--self->n_processos];
+  }
+  if (self->corrente == proc) self->corrente = NULL;
+  proc_destroi(proc);
+}
+
+// retorna o processo com o pid, ou NULL se não existir
+static processo_t *so_busca_processo(so_t *self, int pid)
+{
+  for (int i = 0; i < self->n_processos; i++) {
+    if (self->processos[i]->pid == pid) return self->processos[i];
+  }
+  return NULL;
 }
 
-static void so_chamada_mata_proc(so_t *self)
+// bloqueia o processo; o escalonador vai escolher outro para executar
+static void so_bloqueia_processo(so_t *self, processo_t *proc,
+                                 proc_bloqueio_t motivo)
 {
-  // ainda sem suporte a processos, retorna erro -1
-  console_printf(self->console, "SO: SO_MATA_PROC não implementada");
-  mem_escreve(self->mem, IRQ_END_A, -1);
+  if (proc->estado == PROC_PRONTO) {
+    esc_remove(self->escalonador, proc);
+  }
+  proc_muda_estado(proc, PROC_BLOQUEADO, rel_agora(self->relogio));
+  proc->bloqueio = motivo;
+  esc_bloqueou(self->escalonador, proc);
 }
 
+// desbloqueia o processo, que volta para a fila de prontos
+static void so_desbloqueia_processo(so_t *self, processo_t *proc)
+{
+  proc_muda_estado(proc, PROC_PRONTO, rel_agora(self->relogio));
+  proc->bloqueio = BLOQ_NENHUM;
+  esc_insere(self->escalonador, proc);
+}
 
-// carrega o programa na memória
-// retorna o endereço de carga ou -1
-// está simplesmente lendo para o próximo quadro que nunca foi ocupado,
-//   nem testa se tem memória disponível
-// com memória virtual, a forma mais simples de implementar a carga
-//   de um programa é carregá-lo para a memória secundária, e mapear
-//   todas as páginas da tabela de páginas como inválidas. assim, 
-//   as páginas serão colocadas na memória principal por demanda.
-//   para simplificar ainda mais, a memória secundária pode ser alocada
-//   da forma como a principal está sendo alocada aqui (sem reuso)
-static int so_carrega_programa(so_t *self, char *nome_do_executavel)
+// acrescenta os tempos do processo que está terminando aos da classe do
+//   programa que ele executou
+static void so_contabiliza_fim(so_t *self, processo_t *proc)
+{
+  // guarda a contabilidade do processo, para o relatório em arquivo
+  long agora = rel_agora(self->relogio);
+  proc_muda_estado(proc, proc->estado, agora);
+  proc->contas.t_fim = agora;
+  if (self->n_registros == self->cap_registros) {
+    int cap = self->cap_registros == 0 ? 16 : 2 * self->cap_registros;
+    so_registro_t *r = realloc(self->registros, cap * sizeof(so_registro_t));
+    if (r != NULL) {
+      self->registros = r;
+      self->cap_registros = cap;
+    }
+  }
+  if (self->n_registros < self->cap_registros) {
+    so_registro_t *reg = &self->registros[self->n_registros];
+    reg->pid = proc->pid;
+    reg->programa = strdup(proc->programa);
+    reg->contas = proc->contas;
+    if (reg->programa != NULL) self->n_registros++;
+  }
+
+  // e os tempos por programa, para o relatório na console
+  so_classe_t *classe = NULL;
+  for (int i = 0; i < self->n_classes; i++) {
+    if (strcmp(self->classes[i].programa, proc->programa) == 0) {
+      classe = &self->classes[i];
+      break;
+    }
+  }
+  if (classe == NULL) {
+    so_classe_t *c = realloc(self->classes,
+                             (self->n_classes + 1) * sizeof(so_classe_t));
+    if (c == NULL) return;
+    self->classes = c;
+    classe = &self->classes[self->n_classes];
+    classe->programa = strdup(proc->programa);
+    if (classe->programa == NULL) return;
+    classe->n_processos = 0;
+    classe->soma_retorno = 0;
+    classe->soma_resposta = 0;
+    self->n_classes++;
+  }
+  long t_primeira_exec = proc->contas.t_primeira_exec;
+  if (t_primeira_exec == -1) t_primeira_exec = agora;
+  classe->n_processos++;
+  classe->soma_retorno += agora - proc->contas.t_criacao;
+  classe->soma_resposta += t_primeira_exec - proc->contas.t_criacao;
+}
+
+// contabiliza o fim da ativação corrente do processo de tempo real
+static void so_contabiliza_ativacao(so_t *self, processo_t *proc)
+{
+  long atraso = rel_agora(self->relogio) - proc->prazo_abs;
+  int faixa = 0;
+  while (faixa < N_FAIXAS_ATRASO - 1 && atraso > limite_atraso[faixa]) {
+    faixa++;
+  }
+  self->hist_atraso[faixa]++;
+  self->n_ativacoes_tr++;
+  if (atraso > 0) {
+    proc->n_perdas++;
+    self->n_perdas_tr++;
+  }
+}
+
+// imprime o número de interrupções, os tempos médios de retorno e de
+//   resposta dos processos que terminaram, por programa, e o histograma de
+//   atrasos dos processos de tempo real
+static void so_imprime_relatorio(so_t *self)
+{
+  long total = 0;
+  for (int irq = 0; irq < N_IRQ; irq++) {
+    total += self->n_irq[irq];
+  }
+  console_printf(self->console,
+      "SO: %ld interrupções, %ld tics de quantum (tic %s)", total,
+      self->n_tics, TIC_DINAMICO ? "dinâmico" : "periódico");
+  for (int irq = 0; irq < N_IRQ; irq++) {
+    if (self->n_irq[irq] == 0) continue;
+    console_printf(self->console, "SO:   %s: %ld", irq_nome(irq),
+                   self->n_irq[irq]);
+  }
+  // um relógio que interrompe a cada tic, mesmo com a CPU parada
+  console_printf(self->console, "SO:   com relógio periódico, seriam %ld"
+                 " interrupções do relógio",
+                 rel_agora(self->relogio) / INTERVALO_INTERRUPCAO);
+  so_totais_t tot;
+  so_calcula_totais(self, &tot);
+  long tempo = rel_agora(self->relogio);
+  long n_faltas = tot.n_faltas_leves + tot.n_faltas_pesadas;
+  console_printf(self->console, "SO: utilização %.1f%%, vazão %.2f proc por"
+                 " 1000 tics, %ld trocas de contexto, %.2f faltas de página"
+                 " por 1000 instruções",
+                 tempo == 0 ? 0.0 : 100.0 * tot.t_executando / tempo,
+                 tempo == 0 ? 0.0 : 1000.0 * tot.n_terminados / tempo,
+                 self->n_trocas_contexto,
+                 tot.t_executando == 0 ? 0.0
+                                       : 1000.0 * n_faltas / tot.t_executando);
+  console_printf(self->console,
+                 "SO: cache de programas: %d acertos, %d faltas",
+                 cacheprog_acertos(self->cache_prog),
+                 cacheprog_faltas(self->cache_prog));
+  console_printf(self->console, "SO: escalonador %s, tempos médios:",
+                 esc_nome(self->escalonador));
+  for (int i = 0; i < self->n_classes; i++) {
+    so_classe_t *classe = &self->classes[i];
+    console_printf(self->console, "SO:   %s: %d proc, retorno %ld, resposta %ld",
+                   classe->programa, classe->n_processos,
+                   classe->soma_retorno / classe->n_processos,
+                   classe->soma_resposta / classe->n_processos);
+  }
+  if (self->n_ativacoes_tr == 0) return;
+  console_printf(self->console,
+      "SO: tempo real (%s): %d ativações, %d prazos perdidos",
+      esc_nome_tempo_real(self->escalonador),
+      self->n_ativacoes_tr, self->n_perdas_tr);
+  for (int faixa = 0; faixa < N_FAIXAS_ATRASO; faixa++) {
+    if (faixa < N_FAIXAS_ATRASO - 1) {
+      console_printf(self->console, "SO:   atraso <= %d: %d",
+                     limite_atraso[faixa], self->hist_atraso[faixa]);
+    } else {
+      console_printf(self->console, "SO:   atraso > %d: %d",
+                     limite_atraso[faixa - 1], self->hist_atraso[faixa]);
+    }
+  }
+}
+
+void so_define_perfil(so_t *self, perfil_t *perfil)
+{
+  self->perfil = perfil;
+}
+
+void so_define_amostrador(so_t *self, amostrador_t *amostrador)
+{
+  self->amostrador = amostrador;
+}
+
+void so_define_contadores(so_t *self, contadores_t *contadores)
+{
+  self->contadores = contadores;
+}
+
+// Métricas
+// Os valores são calculados na hora da leitura, percorrendo a tabela de
+//   processos; os processos que esperam E/S são os bloqueados nas filas
+//   dos terminais (não tem disco)
+
+typedef enum {
+  MET_PROCESSOS,
+  MET_PRONTOS,
+  MET_ESPERA_ES,
+  MET_TROCAS_DE_CONTEXTO,
+  MET_FALTAS_LEVES,
+  MET_FALTAS_PESADAS,
+  MET_CACHE_PROG_ACERTOS,
+  MET_CACHE_PROG_FALTAS,
+} so_metrica_t;
+
+static long so_le_metrica(void *fonte, int id)
+{
+  so_t *self = fonte;
+  long n = 0;
+  switch ((so_metrica_t)id) {
+    case MET_PROCESSOS:
+      return self->n_processos;
+    case MET_PRONTOS:
+      for (int i = 0; i < self->n_processos; i++) {
+        if (self->processos[i]->estado == PROC_PRONTO) n++;
+      }
+      return n;
+    case MET_ESPERA_ES:
+      for (int i = 0; i < self->n_processos; i++) {
+        processo_t *proc = self->processos[i];
+        if (proc->estado == PROC_BLOQUEADO
+            && (proc->bloqueio == BLOQ_LE || proc->bloqueio == BLOQ_ESCR)) {
+          n++;
+        }
+      }
+      return n;
+    case MET_TROCAS_DE_CONTEXTO:
+      return self->n_trocas_contexto;
+    case MET_FALTAS_LEVES:
+    case MET_FALTAS_PESADAS: {
+      so_totais_t tot;
+      so_calcula_totais(self, &tot);
+      return id == MET_FALTAS_LEVES ? tot.n_faltas_leves
+                                    : tot.n_faltas_pesadas;
+    }
+    case MET_CACHE_PROG_ACERTOS:
+      return cacheprog_acertos(self->cache_prog);
+    case MET_CACHE_PROG_FALTAS:
+      return cacheprog_faltas(self->cache_prog);
+  }
+  return 0;
+}
+
+void so_registra_metricas(so_t *self, metricas_t *met)
+{
+  met_registra(met, "so_processos", NULL, "Processos existentes",
+               MET_MEDIDOR, self, MET_PROCESSOS, so_le_metrica);
+  met_registra(met, "so_prontos", NULL, "Processos na fila de prontos",
+               MET_MEDIDOR, self, MET_PRONTOS, so_le_metrica);
+  met_registra(met, "so_espera_es", NULL,
+               "Processos bloqueados esperando um terminal",
+               MET_MEDIDOR, self, MET_ESPERA_ES, so_le_metrica);
+  met_registra(met, "so_trocas_de_contexto_total", NULL,
+               "Despachos de um processo diferente do anterior",
+               MET_CONTADOR, self, MET_TROCAS_DE_CONTEXTO, so_le_metrica);
+  met_registra(met, "so_faltas_de_pagina_total", "tipo=\"leve\"",
+               "Faltas de página atendidas pelo SO",
+               MET_CONTADOR, self, MET_FALTAS_LEVES, so_le_metrica);
+  met_registra(met, "so_faltas_de_pagina_total", "tipo=\"pesada\"",
+               "Faltas de página atendidas pelo SO",
+               MET_CONTADOR, self, MET_FALTAS_PESADAS, so_le_metrica);
+  met_registra(met, "so_cache_programas_total", "resultado=\"acerto\"",
+               "Buscas no cache de programas",
+               MET_CONTADOR, self, MET_CACHE_PROG_ACERTOS, so_le_metrica);
+  met_registra(met, "so_cache_programas_total", "resultado=\"falta\"",
+               "Buscas no cache de programas",
+               MET_CONTADOR, self, MET_CACHE_PROG_FALTAS, so_le_metrica);
+}
+
+// Relatório em arquivo
+// A contabilidade de cada processo (dos que terminaram e dos que ainda
+//   existem) é gravada em ARQ_RELATORIO_CSV, uma linha por processo, e em
+//   ARQ_RELATORIO_JSON, junto com os totais do sistema
+// Os tempos são em unidades do relógio; como cada instrução leva uma
+//   unidade, o tempo executando é também o número de instruções executadas
+
+static void so_soma_contas(so_totais_t *tot, proc_contas_t *c)
+{
+  tot->n_processos++;
+  if (c->t_fim != -1) tot->n_terminados++;
+  tot->t_executando += c->t_executando;
+  tot->n_preempcoes += c->n_preempcoes;
+  tot->n_faltas_leves += c->n_faltas_leves;
+  tot->n_faltas_pesadas += c->n_faltas_pesadas;
+}
+
+// calcula os totais do sistema; a contabilidade dos processos que ainda
+//   existem é atualizada até agora
+static void so_calcula_totais(so_t *self, so_totais_t *tot)
+{
+  memset(tot, 0, sizeof(*tot));
+  long agora = rel_agora(self->relogio);
+  for (int i = 0; i < self->n_registros; i++) {
+    so_soma_contas(tot, &self->registros[i].contas);
+  }
+  for (int i = 0; i < self->n_processos; i++) {
+    processo_t *proc = self->processos[i];
+    proc_muda_estado(proc, proc->estado, agora);
+    so_soma_contas(tot, &proc->contas);
+  }
+}
+
+static int so_total_chamadas(proc_contas_t *c)
+{
+  int total = 0;
+  for (int id = 0; id < PROC_N_CHAMADAS; id++) {
+    total += c->n_chamadas[id];
+  }
+  return total;
+}
+
+// tempo entre a criação e o fim (ou a primeira execução), ou -1
+static long so_intervalo(proc_contas_t *c, long t)
+{
+  return t == -1 ? -1 : t - c->t_criacao;
+}
+
+static void so_grava_csv_cabecalho(FILE *arq)
+{
+  fprintf(arq, "pid,programa,criacao,fim,retorno,resposta,executando,pronto");
+  for (int b = BLOQ_NENHUM + 1; b < N_BLOQ; b++) {
+    fprintf(arq, ",bloq_%s", proc_bloqueio_nome(b));
+  }
+  fprintf(arq, ",despachos,preempcoes,faltas_leves,faltas_pesadas,"
+               "chamadas\n");
+}
+
+static void so_grava_csv_processo(FILE *arq, int pid, char *programa,
+                                  proc_contas_t *c)
+{
+  fprintf(arq, "%d,%s,%ld,%ld,%ld,%ld,%ld,%ld", pid, programa,
+          c->t_criacao, c->t_fim, so_intervalo(c, c->t_fim),
+          so_intervalo(c, c->t_primeira_exec), c->t_executando, c->t_pronto);
+  for (int b = BLOQ_NENHUM + 1; b < N_BLOQ; b++) {
+    fprintf(arq, ",%ld", c->t_bloqueado[b]);
+  }
+  fprintf(arq, ",%d,%d,%d,%d,%d\n", c->n_despachos, c->n_preempcoes,
+          c->n_faltas_leves, c->n_faltas_pesadas, so_total_chamadas(c));
+}
+
+// grava uma string JSON, com as aspas
+static void so_grava_json_str(FILE *arq, const char *str)
+{
+  fputc('"', arq);
+  for (; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\') {
+      fprintf(arq, "\\%c", *str);
+    } else if ((unsigned char)*str < ' ') {
+      fprintf(arq, "\\u%04x", *str);
+    } else {
+      fputc(*str, arq);
+    }
+  }
+  fputc('"', arq);
+}
+
+static void so_grava_json_processo(FILE *arq, int pid, char *programa,
+                                   proc_contas_t *c, bool ultimo)
+{
+  fprintf(arq, "    {\"pid\": %d, \"programa\": ", pid);
+  so_grava_json_str(arq, programa);
+  fprintf(arq, ",\n     \"criacao\": %ld, \"fim\": %ld, \"retorno\": %ld,"
+               " \"resposta\": %ld,\n",
+          c->t_criacao, c->t_fim, so_intervalo(c, c->t_fim),
+          so_intervalo(c, c->t_primeira_exec));
+  fprintf(arq, "     \"executando\": %ld, \"pronto\": %ld, \"bloqueado\": {",
+          c->t_executando, c->t_pronto);
+  for (int b = BLOQ_NENHUM + 1; b < N_BLOQ; b++) {
+    fprintf(arq, "%s\"%s\": %ld", b == BLOQ_NENHUM + 1 ? "" : ", ",
+            proc_bloqueio_nome(b), c->t_bloqueado[b]);
+  }
+  fprintf(arq, "},\n     \"despachos\": %d, \"preempcoes\": %d,"
+               " \"faltas_leves\": %d, \"faltas_pesadas\": %d,\n",
+          c->n_despachos, c->n_preempcoes,
+          c->n_faltas_leves, c->n_faltas_pesadas);
+  fprintf(arq, "     \"chamadas\": {");
+  bool primeira = true;
+  for (int id = 0; id < PROC_N_CHAMADAS; id++) {
+    if (c->n_chamadas[id] == 0) continue;
+    fprintf(arq, "%s", primeira ? "" : ", ");
+    if (chamada_nome(id) != NULL) {
+      fprintf(arq, "\"%s\": %d", chamada_nome(id), c->n_chamadas[id]);
+    } else {
+      fprintf(arq, "\"%d\": %d", id, c->n_chamadas[id]);
+    }
+    primeira = false;
+  }
+  fprintf(arq, "}}%s\n", ultimo ? "" : ",");
+}
+
+static void so_grava_json_sistema(so_t *self, FILE *arq, so_totais_t *tot)
+{
+  long tempo = rel_agora(self->relogio);
+  long n_faltas = tot->n_faltas_leves + tot->n_faltas_pesadas;
+  fprintf(arq, "  \"sistema\": {\n");
+  fprintf(arq, "    \"escalonador\": \"%s\",\n", esc_nome(self->escalonador));
+  fprintf(arq, "    \"tempo\": %ld,\n", tempo);
+  fprintf(arq, "    \"executando\": %ld,\n", tot->t_executando);
+  fprintf(arq, "    \"utilizacao\": %.4f,\n",
+          tempo == 0 ? 0.0 : (double)tot->t_executando / tempo);
+  fprintf(arq, "    \"processos\": %d,\n", tot->n_processos);
+  fprintf(arq, "    \"terminados\": %d,\n", tot->n_terminados);
+  fprintf(arq, "    \"vazao_por_1000\": %.4f,\n",
+          tempo == 0 ? 0.0 : 1000.0 * tot->n_terminados / tempo);
+  fprintf(arq, "    \"trocas_de_contexto\": %ld,\n", self->n_trocas_contexto);
+  fprintf(arq, "    \"preempcoes\": %ld,\n", tot->n_preempcoes);
+  fprintf(arq, "    \"faltas_leves\": %ld,\n", tot->n_faltas_leves);
+  fprintf(arq, "    \"faltas_pesadas\": %ld,\n", tot->n_faltas_pesadas);
+  fprintf(arq, "    \"faltas_por_1000_instrucoes\": %.4f,\n",
+          tot->t_executando == 0 ? 0.0
+                                 : 1000.0 * n_faltas / tot->t_executando);
+  fprintf(arq, "    \"interrupcoes\": {");
+  for (int irq = 0; irq < N_IRQ; irq++) {
+    fprintf(arq, "%s", irq == 0 ? "" : ", ");
+    so_grava_json_str(arq, irq_nome(irq));
+    fprintf(arq, ": %ld", self->n_irq[irq]);
+  }
+  fprintf(arq, "}\n  },\n");
+}
+
+static void so_grava_relatorio(so_t *self)
+{
+  so_totais_t tot;
+  so_calcula_totais(self, &tot);
+
+  FILE *csv = fopen(ARQ_RELATORIO_CSV, "w");
+  if (csv != NULL) {
+    so_grava_csv_cabecalho(csv);
+    for (int i = 0; i < self->n_registros; i++) {
+      so_registro_t *reg = &self->registros[i];
+      so_grava_csv_processo(csv, reg->pid, reg->programa, &reg->contas);
+    }
+    for (int i = 0; i < self->n_processos; i++) {
+      processo_t *proc = self->processos[i];
+      so_grava_csv_processo(csv, proc->pid, proc->programa, &proc->contas);
+    }
+    fclose(csv);
+  }
+
+  FILE *json = fopen(ARQ_RELATORIO_JSON, "w");
+  if (json != NULL) {
+    fprintf(json, "{\n");
+    so_grava_json_sistema(self, json, &tot);
+    fprintf(json, "  \"processos\": [\n");
+    int n = 0;
+    for (int i = 0; i < self->n_registros; i++) {
+      so_registro_t *reg = &self->registros[i];
+      n++;
+      so_grava_json_processo(json, reg->pid, reg->programa, &reg->contas,
+                             n == tot.n_processos);
+    }
+    for (int i = 0; i < self->n_processos; i++) {
+      processo_t *proc = self->processos[i];
+      n++;
+      so_grava_json_processo(json, proc->pid, proc->programa, &proc->contas,
+                             n == tot.n_processos);
+    }
+    fprintf(json, "  ]\n}\n");
+    fclose(json);
+  }
+}
+
+
+// Gerência de memória
+
+// aloca uma página da memória secundária
+// retorna o número da página, ou -1 se a memória secundária estiver cheia
+static int so_aloca_pagina_sec(so_t *self)
+{
+  if (self->n_paginas_sec_livres > 0) {
+    return self->paginas_sec_livres[--self->n_paginas_sec_livres];
+  }
+  if (self->pagina_sec_nova >= self->n_paginas_sec) return -1;
+  return self->pagina_sec_nova++;
+}
+
+// libera as páginas da memória secundária do vetor 'paginas' (as que não
+//   forem -1)
+// o conteúdo das páginas é descartado (e elas ficam zeradas, prontas para
+//   reuso); as páginas consecutivas são descartadas juntas, para devolver
+//   ao hospedeiro a memória que elas ocupam
+static void so_libera_paginas_sec(so_t *self, int n, int paginas[n])
+{
+  int ini = -1;  // início da sequência de páginas consecutivas
+  int tam = 0;   // tamanho da sequência
+  for (int i = 0; i < n; i++) {
+    int pagina = paginas[i];
+    if (pagina == -1) continue;
+    if (self->n_paginas_sec_livres == self->cap_paginas_sec_livres) {
+      int cap = self->cap_paginas_sec_livres * 2 + 100;
+      int *p = realloc(self->paginas_sec_livres, cap * sizeof(int));
+      if (p == NULL) break;
+      self->paginas_sec_livres = p;
+      self->cap_paginas_sec_livres = cap;
+    }
+    self->paginas_sec_livres[self->n_paginas_sec_livres++] = pagina;
+    if (pagina == ini + tam) {
+      tam++;
+      continue;
+    }
+    if (tam > 0) {
+      mem_descarta_bloco(self->mem_sec, ini * TAM_PAGINA, tam * TAM_PAGINA);
+    }
+    ini = pagina;
+    tam = 1;
+  }
+  if (tam > 0) {
+    mem_descarta_bloco(self->mem_sec, ini * TAM_PAGINA, tam * TAM_PAGINA);
+  }
+}
+
+// coloca a página que está no quadro de volta na memória secundária
+//   (se tiver sido alterada), e marca o quadro como livre
+// uma página zerada por demanda só ganha uma página na memória secundária
+//   quando é alterada
+static void so_libera_quadro(so_t *self, int quadro)
+{
+  processo_t *proc = self->quadro_proc[quadro];
+  int pagina = self->quadro_pagina[quadro];
+  if (pagina == -1) return;
+  if (tabpag_bit_alteracao(proc->tabpag, pagina)) {
+    if (proc->pagina_sec[pagina] == -1) {
+      proc->pagina_sec[pagina] = so_aloca_pagina_sec(self);
+    }
+    if (proc->pagina_sec[pagina] == -1) {
+      console_printf(self->console,
+          "SO: memória secundária cheia, página %d do processo %d perdida",
+          pagina, proc->pid);
+    } else {
+      int end_sec = proc->pagina_sec[pagina] * TAM_PAGINA;
+      RASTRO_EVENTO(RASTRO_MEM_SEC, rel_agora(self->relogio), proc->pid,
+                    pagina, 1);
+      mem_copia_entre(self->mem_sec, end_sec,
+                      self->mem, quadro * TAM_PAGINA, TAM_PAGINA);
+    }
+  }
+  tabpag_define_quadro(proc->tabpag, pagina, -1);
+  self->quadro_proc[quadro] = NULL;
+  self->quadro_pagina[quadro] = -1;
+  self->quadros_livres[self->n_quadros_livres++] = quadro;
+}
+
+// retorna um quadro livre; se não tiver, libera um (algoritmo FIFO)
+static int so_obtem_quadro(so_t *self)
+{
+  if (self->n_quadros_livres == 0) {
+    int vitima = self->quadro_vitima;
+    self->quadro_vitima++;
+    if (self->quadro_vitima >= self->n_quadros) {
+      self->quadro_vitima = QUADRO_INI_USUARIO;
+    }
+    so_libera_quadro(self, vitima);
+  }
+  return self->quadros_livres[--self->n_quadros_livres];
+}
+
+// libera os quadros e a memória secundária ocupados pelo processo
+// o conteúdo das páginas não é salvo
+static void so_libera_memoria(so_t *self, processo_t *proc)
+{
+  for (int quadro = 0; quadro < self->n_quadros; quadro++) {
+    if (self->quadro_proc[quadro] == proc) {
+      tabpag_define_quadro(proc->tabpag, self->quadro_pagina[quadro], -1);
+      self->quadro_proc[quadro] = NULL;
+      self->quadro_pagina[quadro] = -1;
+      self->quadros_livres[self->n_quadros_livres++] = quadro;
+    }
+  }
+  so_libera_paginas_sec(self, proc->n_paginas, proc->pagina_sec);
+  free(proc->pagina_sec);
+  proc->pagina_sec = NULL;
+  proc->n_paginas = 0;
+}
+
+// atende uma falta de página no endereço virtual end_virt do processo
+// retorna false se o endereço não pertence ao processo
+static bool so_trata_falta_de_pagina(so_t *self, processo_t *proc,
+                                     int end_virt)
+{
+  if (end_virt < 0) return false;
+  int pagina = end_virt / TAM_PAGINA;
+  if (pagina >= proc->n_paginas) return false;
+  RASTRO_EVENTO(RASTRO_FALTA_INI, rel_agora(self->relogio), proc->pid,
+                pagina, 0);
+  int quadro = so_obtem_quadro(self);
+  int end_fis = quadro * TAM_PAGINA;
+  err_t err;
+  if (proc->pagina_sec[pagina] == -1) {
+    // página zerada por demanda, não precisa ler a memória secundária
+    err = mem_preenche_bloco(self->mem, end_fis, TAM_PAGINA, 0);
+  } else {
+    int end_sec = proc->pagina_sec[pagina] * TAM_PAGINA;
+    RASTRO_EVENTO(RASTRO_MEM_SEC, rel_agora(self->relogio), proc->pid,
+                  pagina, 0);
+    err = mem_copia_entre(self->mem, end_fis,
+                          self->mem_sec, end_sec, TAM_PAGINA);
+  }
+  if (err != ERR_OK) {
+    console_printf(self->console,
+        "SO: erro na leitura da página %d da memória secundária", pagina);
+    self->quadros_livres[self->n_quadros_livres++] = quadro;
+    RASTRO_EVENTO(RASTRO_FALTA_FIM, rel_agora(self->relogio), proc->pid,
+                  pagina, -1);
+    return false;
+  }
+  self->quadro_proc[quadro] = proc;
+  self->quadro_pagina[quadro] = pagina;
+  tabpag_define_quadro(proc->tabpag, pagina, quadro);
+  if (proc->pagina_sec[pagina] == -1) {
+    proc->contas.n_faltas_leves++;
+  } else {
+    proc->contas.n_faltas_pesadas++;
+  }
+  if (self->contadores != NULL) cont_conta_falta(self->contadores);
+  console_printf(self->console,
+      "SO: falta de página, processo %d, página %d no quadro %d%s",
+      proc->pid, pagina, quadro,
+      proc->pagina_sec[pagina] == -1 ? " (zerada)" : "");
+  RASTRO_EVENTO(RASTRO_FALTA_FIM, rel_agora(self->relogio), proc->pid,
+                pagina, quadro);
+  return true;
+}
+
+
+// copia 'tam' valores a partir de 'dados' para a memória secundária, nas
+//   páginas correspondentes aos endereços virtuais a partir de 'end_virt',
+//   alocando as páginas que ainda não foram alocadas
+static bool so_copia_para_sec(so_t *self, int pagina_sec[], int end_virt,
+                              int tam, const int *dados)
+{
+  while (tam > 0) {
+    int pagina = end_virt / TAM_PAGINA;
+    int desloc = end_virt % TAM_PAGINA;
+    int n = TAM_PAGINA - desloc;
+    if (n > tam) n = tam;
+    if (pagina_sec[pagina] == -1) {
+      pagina_sec[pagina] = so_aloca_pagina_sec(self);
+      if (pagina_sec[pagina] == -1) return false;
+    }
+    int end_sec = pagina_sec[pagina] * TAM_PAGINA + desloc;
+    if (mem_copia_bloco(self->mem_sec, end_sec, n, dados) != ERR_OK) {
+      return false;
+    }
+    end_virt += n;
+    dados += n;
+    tam -= n;
+  }
+  return true;
+}
+
+// carrega o programa na memória secundária, como espaço de endereçamento
+//   do processo (que ainda não deve ter um)
+// retorna o endereço de início da execução ou -1
+// só as páginas que contêm dados do programa são colocadas na memória
+//   secundária; as que não têm (regiões reservadas com ESPACO no formato
+//   binário) são zeradas por demanda, quando forem acessadas
+// a tabela de páginas fica vazia, as páginas serão colocadas na memória
+//   principal por demanda
+static int so_carrega_programa(so_t *self, processo_t *proc,
+                               char *nome_do_executavel)
 {
   // programa para executar na nossa CPU
-  programa_t *prog = prog_cria(nome_do_executavel);
+  // o programa pertence ao cache, não deve ser destruído aqui
+  programa_t *prog = cacheprog_pega(self->cache_prog, nome_do_executavel);
   if (prog == NULL) {
     console_printf(self->console,
         "Erro na leitura do programa '%s'\n", nome_do_executavel);
@@ -388,64 +2154,128 @@ static int so_carrega_programa(so_t *self, char *nome_do_executavel)
 
   int end_virt_ini = prog_end_carga(prog);
   int end_virt_fim = end_virt_ini + prog_tamanho(prog) - 1;
-  int pagina_ini = end_virt_ini / TAM_PAGINA;
-  int pagina_fim = end_virt_fim / TAM_PAGINA;
-  int quadro_ini = self->quadro_livre;
-  // mapeia as páginas nos quadros
-  int quadro = quadro_ini;
-  for (int pagina = pagina_ini; pagina <= pagina_fim; pagina++) {
-    tabpag_define_quadro(self->tabpag, pagina, quadro);
-    quadro++;
-  }
-  self->quadro_livre = quadro;
-
-  // carrega o programa na memória principal
-  int end_fis_ini = quadro_ini * TAM_PAGINA;
-  int end_fis = end_fis_ini;
-  for (int end_virt = end_virt_ini; end_virt <= end_virt_fim; end_virt++) {
-    if (mem_escreve(self->mem, end_fis, prog_dado(prog, end_virt)) != ERR_OK) {
+  if (end_virt_ini < 0) {
+    console_printf(self->console,
+        "Erro na carga do programa, end virt %d\n", end_virt_ini);
+    return -1;
+  }
+  int n_paginas = end_virt_fim / TAM_PAGINA + 1;
+  int *pagina_sec = malloc(n_paginas * sizeof(int));
+  if (pagina_sec == NULL) return -1;
+  for (int pagina = 0; pagina < n_paginas; pagina++) {
+    pagina_sec[pagina] = -1;
+  }
+
+  // carrega os segmentos do programa na memória secundária, em blocos
+  for (int seg = 0; seg < prog_num_segmentos(prog); seg++) {
+    int end_seg, tam_seg;
+    const int *dados = prog_segmento(prog, seg, &end_seg, &tam_seg);
+    if (dados == NULL) continue;  // segmento zerado
+    if (!so_copia_para_sec(self, pagina_sec, end_seg, tam_seg, dados)) {
       console_printf(self->console,
-          "Erro na carga da memória, end virt %d fís %d\n", end_virt, end_fis);
+          "Erro na carga da memória secundária, end virt %d\n", end_seg);
+      so_libera_paginas_sec(self, n_paginas, pagina_sec);
+      free(pagina_sec);
       return -1;
     }
-    end_fis++;
   }
-  prog_destroi(prog);
+  int n_zeradas = 0;
+  for (int pagina = 0; pagina < n_paginas; pagina++) {
+    if (pagina_sec[pagina] == -1) n_zeradas++;
+  }
+
+  proc->n_paginas = n_paginas;
+  proc->pagina_sec = pagina_sec;
+
   console_printf(self->console,
-      "SO: carga de '%s' em V%d-%d F%d-%d", nome_do_executavel,
-                 end_virt_ini, end_virt_fim, end_fis_ini, end_fis - 1);
-  return end_virt_ini;
+      "SO: carga de '%s' em V%d-%d, %d páginas, %d zeradas por demanda",
+      nome_do_executavel, end_virt_ini, end_virt_fim, n_paginas, n_zeradas);
+  return prog_end_inicio(prog);
+}
+
+// lê 'tam' valores da memória do processo, a partir do endereço virtual
+//   'end_virt', para o vetor 'valores'
+// retorna false se erro de acesso à memória (endereço fora do processo)
+// Cada valor do espaço de endereçamento do processo pode estar em memória
+//   principal ou secundária; se não estiver na principal, a página é
+//   trazida como em uma falta de página
+// A leitura é feita em blocos, até o final de cada página
+static bool so_le_do_processo(so_t *self, processo_t *proc, int end_virt,
+                              int tam, int valores[tam])
+{
+  if (end_virt < 0) return false;
+  // a MMU traduz com a tabela do processo; a tabela do processo corrente
+  //   é recolocada quando ele for despachado
+  mmu_define_tabpag(self->mmu, proc->tabpag);
+  while (tam > 0) {
+    int n = TAM_PAGINA - end_virt % TAM_PAGINA;
+    if (n > tam) n = tam;
+    err_t err = mmu_le_bloco(self->mmu, end_virt, n, valores, usuario);
+    if (err == ERR_PAG_AUSENTE || err == ERR_END_INV) {
+      if (!so_trata_falta_de_pagina(self, proc, end_virt)) return false;
+      err = mmu_le_bloco(self->mmu, end_virt, n, valores, usuario);
+    }
+    if (err != ERR_OK) return false;
+    end_virt += n;
+    valores += n;
+    tam -= n;
+  }
+  return true;
+}
+
+// copia os 'tam' valores do vetor 'valores' para a memória do processo, a
+//   partir do endereço virtual 'end_virt'
+// retorna false se erro de acesso à memória (endereço fora do processo)
+// As páginas que não estiverem na memória principal são trazidas como em
+//   uma falta de página
+static bool so_escreve_no_processo(so_t *self, processo_t *proc, int end_virt,
+                                   int tam, const int valores[tam])
+{
+  if (end_virt < 0) return false;
+  mmu_define_tabpag(self->mmu, proc->tabpag);
+  while (tam > 0) {
+    int n = TAM_PAGINA - end_virt % TAM_PAGINA;
+    if (n > tam) n = tam;
+    err_t err = mmu_escreve_bloco(self->mmu, end_virt, n, valores, usuario);
+    if (err == ERR_PAG_AUSENTE || err == ERR_END_INV) {
+      if (!so_trata_falta_de_pagina(self, proc, end_virt)) return false;
+      err = mmu_escreve_bloco(self->mmu, end_virt, n, valores, usuario);
+    }
+    if (err != ERR_OK) return false;
+    end_virt += n;
+    valores += n;
+    tam -= n;
+  }
+  return true;
 }
 
 // copia uma string da memória do processo para o vetor str.
 // retorna false se erro (string maior que vetor, valor não ascii na memória,
 //   erro de acesso à memória)
-// o endereço é um endereço virtual de um processo.
-// Com processos e memória virtual implementados, esta função deve também
-//   receber o processo como argumento
-// Cada valor do espaço de endereçamento do processo pode estar em memória
-//   principal ou secundária
-// O endereço é um endereço virtual de um processo.
-// Com processos e memória virtual implementados, esta função deve também
-//   receber o processo como argumento
-// Com memória virtual, cada valor do espaço de endereçamento do processo
-//   pode estar em memória principal ou secundária
+// O endereço é um endereço virtual do processo 'proc'.
+// A cópia é feita uma página por vez, para não acessar páginas além do
+//   final da string
 static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
-                                     int end_virt/*, processo*/)
+                                     int end_virt, processo_t *proc)
 {
-  for (int indice_str = 0; indice_str < tam; indice_str++) {
-    int caractere;
-    // não tem memória virtual implementada, posso usar a mmu para traduzir
-    //   os endereços e acessar a memória
-    if (mmu_le(self->mmu, end_virt + indice_str, &caractere, usuario) != ERR_OK) {
-      return false;
-    }
-    if (caractere < 0 || caractere > 255) {
-      return false;
-    }
-    str[indice_str] = caractere;
-    if (caractere == 0) {
-      return true;
+  if (end_virt < 0) return false;
+  int indice_str = 0;
+  while (indice_str < tam) {
+    int end = end_virt + indice_str;
+    int n = TAM_PAGINA - end % TAM_PAGINA;
+    if (n > tam - indice_str) n = tam - indice_str;
+    int bloco[TAM_PAGINA];
+    if (!so_le_do_processo(self, proc, end, n, bloco)) return false;
+    for (int i = 0; i < n; i++) {
+      int caractere = bloco[i];
+      if (caractere < 0 || caractere > 255) {
+        return false;
+      }
+      str[indice_str] = caractere;
+      if (caractere == 0) {
+        return true;
+      }
+      indice_str++;
     }
   }
   // estourou o tamanho de str
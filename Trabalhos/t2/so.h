@@ -12,11 +12,34 @@ typedef struct so_t so_t;
 #include "cpu.h"
 #include "console.h"
 #include "relogio.h"
-
-so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu,
+#include "metricas.h"
+#include "perfil.h"
+#include "amostrador.h"
+#include "contadores.h"
+
+// cria o SO
+// mem é a memória principal, mem_sec a secundária, onde são mantidas as
+//   páginas dos programas que não estão na principal
+so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_sec, mmu_t *mmu,
               console_t *console, relogio_t *relogio);
 void so_destroi(so_t *self);
 
+// define o perfil de execução em que o SO informa o programa que a CPU
+//   está executando (NULL se não tiver)
+void so_define_perfil(so_t *self, perfil_t *perfil);
+
+// define o amostrador em que o SO informa o processo que a CPU está
+//   executando (NULL se não tiver)
+void so_define_amostrador(so_t *self, amostrador_t *amostrador);
+
+// define os contadores de desempenho que os processos acessam pelas
+//   chamadas SO_CONTADOR e SO_CONTADOR_CMD (NULL se não tiver)
+void so_define_contadores(so_t *self, contadores_t *contadores);
+
+// registra as métricas do SO: processos (total, prontos e esperando E/S),
+//   trocas de contexto e faltas de página, por tipo
+void so_registra_metricas(so_t *self, metricas_t *met);
+
 // Chamadas de sistema
 // Uma chamada de sistema é realizada colocando a identificação da
 //   chamada (um dos valores abaixo) no registrador A e executando a
@@ -40,6 +63,23 @@ void so_destroi(so_t *self);
 // retorna em A: 0 se OK ou um código de erro negativo
 #define SO_ESCR        2
 
+// lê caracteres do dispositivo de entrada do processo, para a memória do
+//   processo
+// recebe em X o endereço de 2 valores na memória do processo: o endereço
+//   onde colocar os caracteres lidos e o número máximo de caracteres a ler
+// bloqueia o processo até ter pelo menos um caractere; lê todos os que
+//   estiverem disponíveis, até o máximo
+// retorna em A: o número de caracteres lidos ou um código de erro negativo
+#define SO_LE_BLOCO   13
+
+// escreve caracteres da memória do processo no dispositivo de saída
+// recebe em X o endereço de 2 valores na memória do processo: o endereço
+//   do primeiro caractere a escrever e o número de caracteres
+// bloqueia o processo até que todos tenham sido escritos
+// retorna em A: o número de caracteres escritos ou um código de erro
+//   negativo
+#define SO_ESCR_BLOCO 14
+
 // #define SO_ABRE        3
 // #define SO_FECHA       4
 // #define SO_SEL_LE      5
@@ -76,4 +116,118 @@ void so_destroi(so_t *self);
 // retorna sem bloquear, com erro, se não existir processo com esse pid
 #define SO_ESPERA_PROC 9
 
+// altera a prioridade do processo chamador
+// recebe em X o novo valor de nice, entre -20 (mais prioritário) e 19
+//   (menos prioritário); um processo é criado com nice 0
+// o valor de nice só é considerado pelo escalonador CFS, em que define a
+//   parte da CPU que o processo recebe em relação aos demais
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_NICE       10
+
+// suspende o processo chamador por um tempo
+// recebe em X o tempo, em unidades do relógio (instruções executadas)
+// o processo fica bloqueado até passar pelo menos esse tempo; se o tempo
+//   não for positivo, não bloqueia
+// retorna em A: 0
+#define SO_DORME      17
+
+// Contadores de desempenho
+// Os processos podem medir a execução pelos contadores de desempenho da
+//   máquina (ver contadores.h), que contam tudo o que a CPU executa, não
+//   só o processo. Zerar ou congelar os contadores afeta todos os
+//   processos.
+
+// lê um contador de desempenho
+// recebe em X o número do contador (CONT_INSTRUCOES etc, ver contadores.h)
+// retorna em A: os 32 bits de baixo do valor do contador, ou -1 se o
+//   contador for inválido ou não houver contadores
+// para que o valor caiba em A, as medidas devem ser feitas em intervalos
+//   curtos, zerando os contadores no início
+#define SO_CONTADOR       18
+
+// executa um comando nos contadores de desempenho
+// recebe em X o comando (CONT_ZERA, CONT_CONGELA ou CONT_DESCONGELA)
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_CONTADOR_CMD   19
+
+// Chamadas para processos de tempo real
+// Um processo de tempo real é periódico: a cada período ele é ativado,
+//   e deve terminar o trabalho dessa ativação antes do prazo. Ele tem
+//   prioridade sobre todos os processos que não são de tempo real.
+// Todos os tempos são em unidades do relógio (instruções executadas).
+
+// coloca o processo chamador na classe de tempo real
+// recebe em X o endereço de 3 valores na memória do processo: o período,
+//   o tempo de execução no pior caso em cada período (WCET) e o prazo,
+//   relativo ao início do período (0 para prazo igual ao período)
+// o período atual começa na chamada
+// o processo só é admitido se a utilização da CPU pelos processos de tempo
+//   real, incluindo ele, permitir que todos cumpram seus prazos
+// retorna em A: 0 se OK ou um código de erro negativo (não admitido)
+#define SO_TEMPO_REAL     11
+
+// termina o trabalho do período atual, e bloqueia o processo até o início
+//   do próximo período
+// retorna em A: 0 se OK ou um código de erro negativo (processo não é de
+//   tempo real)
+#define SO_ESPERA_PERIODO 12
+
+// Anel de chamadas
+// Um processo pode registrar uma região da sua memória onde coloca pedidos
+//   de E/S sem fazer uma chamada de sistema para cada um. A região contém
+//   um anel de submissão, onde o processo coloca os pedidos, e um anel de
+//   completamento, onde o SO coloca os resultados. O SO olha o anel de
+//   submissão quando o processo faz uma chamada (SO_ANEL_ENTRA), que serve
+//   para entregar vários pedidos de uma vez e para esperar por
+//   completamentos; um pedido que não pode ser atendido na hora (esperando
+//   um terminal ou um processo) é atendido pelo SO assim que puder, junto
+//   com os seguintes, sem outra chamada.
+// Formato da região, em posições de memória a partir do início:
+//   ANEL_N            número de entradas de cada anel (até ANEL_MAX)
+//   ANEL_SUB_CABECA   pedidos já consumidos (incrementado pelo SO)
+//   ANEL_SUB_CAUDA    pedidos colocados (incrementado pelo processo)
+//   ANEL_COMP_CABECA  completamentos já consumidos (pelo processo)
+//   ANEL_COMP_CAUDA   completamentos colocados (pelo SO)
+//   a partir de ANEL_PEDIDOS, N pedidos de ANEL_TAM_PEDIDO valores:
+//     operação, argumento e marca
+//   em seguida, N completamentos de ANEL_TAM_COMPL valores: a marca do
+//     pedido e o resultado
+// Os contadores só crescem; a entrada correspondente a um contador é a do
+//   valor dele módulo N.
+// Os pedidos são atendidos em ordem; um pedido que ainda não pode ser
+//   atendido atrasa os seguintes. As operações são:
+//   SO_LE          lê um caractere; o resultado é o caractere
+//   SO_ESCR        escreve o caractere do argumento; o resultado é 0
+//   SO_ESPERA_PROC espera o processo com o pid do argumento terminar; o
+//                  resultado é 0 (ou -1 se for o próprio processo)
+//   SO_DORME       espera passar o tempo do argumento, contado a partir de
+//                  quando chega a vez do pedido; o resultado é 0
+//   outras operações têm resultado -1
+
+#define ANEL_N           0
+#define ANEL_SUB_CABECA  1
+#define ANEL_SUB_CAUDA   2
+#define ANEL_COMP_CABECA 3
+#define ANEL_COMP_CAUDA  4
+#define ANEL_PEDIDOS     5
+#define ANEL_TAM_PEDIDO  3
+#define ANEL_TAM_COMPL   2
+#define ANEL_MAX        64
+
+// registra o anel de chamadas do processo
+// recebe em X o endereço do anel na memória do processo, ou -1 para
+//   desregistrar
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_ANEL_REGISTRA  15
+
+// atende os pedidos do anel do processo, e espera completamentos
+// recebe em X o número de completamentos (ainda não consumidos) que o
+//   processo quer que existam; bloqueia o processo até que existam
+// se todos os pedidos do anel já foram atendidos, não bloqueia (ou, se
+//   estava bloqueado, volta), mesmo que existam menos completamentos que
+//   X, porque nenhum outro viria
+// retorna em A: o número de completamentos disponíveis ou um código de
+//   erro negativo
+#define SO_ANEL_ENTRA     16
+
 #endif // SO_H
@@ -0,0 +1,185 @@
+#include "tabsimb.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+  int endereco;
+  int linha;         // para as linhas
+  char *nome;        // para os rótulos
+  bool subrotina;    // para os rótulos: se é chamado por CHAMA
+} simbolo_t;
+
+// os rótulos e as linhas, em ordem de endereço, e as subrotinas (os
+//   números dos rótulos chamados por CHAMA), em ordem
+struct tabsimb_t {
+  simbolo_t *rotulos;
+  int n_rotulos;
+  simbolo_t *linhas;
+  int n_linhas;
+  int *subrotinas;
+  int n_subrotinas;
+};
+
+static int compara_simbolo(const void *a, const void *b)
+{
+  const simbolo_t *sa = a, *sb = b;
+  return sa->endereco - sb->endereco;
+}
+
+static void insere_simbolo(simbolo_t **tab, int *n, simbolo_t simb)
+{
+  simbolo_t *t = realloc(*tab, (*n + 1) * sizeof(simbolo_t));
+  if (t == NULL) {
+    free(simb.nome);
+    return;
+  }
+  *tab = t;
+  (*tab)[(*n)++] = simb;
+}
+
+// retorna o índice do último símbolo da tabela com endereço até 'end', ou
+//   -1 se não tiver
+static int busca(simbolo_t *tab, int n, int end)
+{
+  int ini = 0, fim = n - 1, achou = -1;
+  while (ini <= fim) {
+    int meio = (ini + fim) / 2;
+    if (tab[meio].endereco <= end) {
+      achou = meio;
+      ini = meio + 1;
+    } else {
+      fim = meio - 1;
+    }
+  }
+  return achou;
+}
+
+// lê o arquivo, e retorna os endereços chamados por CHAMA (em *pchamados)
+static void le_arquivo(tabsimb_t *self, FILE *arq, int **pchamados,
+                       int *pn_chamados)
+{
+  char linha[200];
+  while (fgets(linha, sizeof(linha), arq) != NULL) {
+    simbolo_t simb = { 0, 0, NULL, false };
+    char nome[sizeof(linha)];
+    if (sscanf(linha, "R %d %s", &simb.endereco, nome) == 2) {
+      simb.nome = strdup(nome);
+      if (simb.nome != NULL) {
+        insere_simbolo(&self->rotulos, &self->n_rotulos, simb);
+      }
+    } else if (sscanf(linha, "L %d %d", &simb.endereco, &simb.linha) == 2) {
+      insere_simbolo(&self->linhas, &self->n_linhas, simb);
+    } else if (sscanf(linha, "C %d", &simb.endereco) == 1) {
+      int *c = realloc(*pchamados, (*pn_chamados + 1) * sizeof(int));
+      if (c == NULL) continue;
+      *pchamados = c;
+      c[(*pn_chamados)++] = simb.endereco;
+    }
+  }
+}
+
+tabsimb_t *tabsimb_le(char *programa)
+{
+  tabsimb_t *self = calloc(1, sizeof(*self));
+  if (self == NULL) return NULL;
+  char nome[strlen(programa) + 5];
+  strcpy(nome, programa);
+  char *ponto = strrchr(nome, '.');
+  if (ponto != NULL) *ponto = '\0';
+  strcat(nome, ".sym");
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) return self;
+  int *chamados = NULL;
+  int n_chamados = 0;
+  le_arquivo(self, arq, &chamados, &n_chamados);
+  fclose(arq);
+  qsort(self->rotulos, self->n_rotulos, sizeof(simbolo_t), compara_simbolo);
+  qsort(self->linhas, self->n_linhas, sizeof(simbolo_t), compara_simbolo);
+  // marca os rótulos chamados, e faz a lista das subrotinas
+  for (int i = 0; i < n_chamados; i++) {
+    int r = busca(self->rotulos, self->n_rotulos, chamados[i]);
+    if (r != -1 && self->rotulos[r].endereco == chamados[i]) {
+      self->rotulos[r].subrotina = true;
+    }
+  }
+  free(chamados);
+  self->subrotinas = malloc(self->n_rotulos * sizeof(int));
+  if (self->subrotinas != NULL) {
+    for (int r = 0; r < self->n_rotulos; r++) {
+      if (self->rotulos[r].subrotina) {
+        self->subrotinas[self->n_subrotinas++] = r;
+      }
+    }
+  }
+  return self;
+}
+
+void tabsimb_destroi(tabsimb_t *self)
+{
+  for (int i = 0; i < self->n_rotulos; i++) {
+    free(self->rotulos[i].nome);
+  }
+  free(self->rotulos);
+  free(self->linhas);
+  free(self->subrotinas);
+  free(self);
+}
+
+int tabsimb_n_rotulos(tabsimb_t *self)
+{
+  return self->n_rotulos;
+}
+
+char *tabsimb_rotulo(tabsimb_t *self, int i, int *pend)
+{
+  *pend = self->rotulos[i].endereco;
+  return self->rotulos[i].nome;
+}
+
+int tabsimb_busca_rotulo(tabsimb_t *self, int end)
+{
+  return busca(self->rotulos, self->n_rotulos, end);
+}
+
+int tabsimb_busca_subrotina(tabsimb_t *self, int end)
+{
+  // busca binária na lista das subrotinas, pelo endereço dos rótulos
+  int ini = 0, fim = self->n_subrotinas - 1, achou = -1;
+  while (ini <= fim) {
+    int meio = (ini + fim) / 2;
+    if (self->rotulos[self->subrotinas[meio]].endereco <= end) {
+      achou = self->subrotinas[meio];
+      ini = meio + 1;
+    } else {
+      fim = meio - 1;
+    }
+  }
+  return achou;
+}
+
+int tabsimb_linha(tabsimb_t *self, int end)
+{
+  int l = busca(self->linhas, self->n_linhas, end);
+  return l == -1 ? -1 : self->linhas[l].linha;
+}
+
+char *tabsimb_descreve(tabsimb_t *self, int end, int tam, char desc[tam])
+{
+  int r = tabsimb_busca_rotulo(self, end);
+  int n;
+  if (r == -1) {
+    n = snprintf(desc, tam, "?");
+  } else if (self->rotulos[r].endereco == end) {
+    n = snprintf(desc, tam, "%s", self->rotulos[r].nome);
+  } else {
+    n = snprintf(desc, tam, "%s+%d", self->rotulos[r].nome,
+                 end - self->rotulos[r].endereco);
+  }
+  int linha = tabsimb_linha(self, end);
+  if (linha != -1 && n < tam) {
+    snprintf(desc + n, tam - n, " (linha %d)", linha);
+  }
+  return desc;
+}
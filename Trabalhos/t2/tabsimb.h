@@ -0,0 +1,47 @@
+#ifndef TABSIMB_H
+#define TABSIMB_H
+
+// tabela de símbolos de um programa
+// lida do arquivo gerado pelo montador junto com o programa (o arquivo com
+//   o nome do programa e a extensão '.sym', ver montador.c), para que as
+//   análises da execução mostrem os endereços pelos rótulos do fonte
+
+#include <stdbool.h>
+
+typedef struct tabsimb_t tabsimb_t;
+
+// lê a tabela de símbolos do programa 'programa' (o nome do executável;
+//   a extensão é trocada por '.sym')
+// se o arquivo não existir, a tabela fica vazia
+// retorna NULL em caso de erro de alocação
+tabsimb_t *tabsimb_le(char *programa);
+
+// destrói a tabela
+void tabsimb_destroi(tabsimb_t *self);
+
+// retorna o número de rótulos na tabela
+// os rótulos são numerados de 0 a n-1, em ordem de endereço
+int tabsimb_n_rotulos(tabsimb_t *self);
+
+// retorna o nome do rótulo 'i', e coloca em *pend o seu endereço
+char *tabsimb_rotulo(tabsimb_t *self, int i, int *pend);
+
+// retorna o número do rótulo em que está o endereço 'end' (o último rótulo
+//   com endereço até 'end'), ou -1 se não tiver
+int tabsimb_busca_rotulo(tabsimb_t *self, int end);
+
+// retorna o número do rótulo da subrotina em que está o endereço 'end', ou
+//   -1 se não estiver em uma subrotina
+// as subrotinas são os endereços chamados por CHAMA no programa; cada uma
+//   vai até o início da seguinte, e o código antes da primeira não está em
+//   subrotina
+int tabsimb_busca_subrotina(tabsimb_t *self, int end);
+
+// retorna a linha do fonte em que está o endereço 'end', ou -1
+int tabsimb_linha(tabsimb_t *self, int end);
+
+// coloca em 'desc' a descrição do endereço, como "laco+3 (linha 42)"
+// retorna 'desc'
+char *tabsimb_descreve(tabsimb_t *self, int end, int tam, char desc[tam]);
+
+#endif // TABSIMB_H
@@ -0,0 +1,268 @@
+#include "temporizador.h"
+#include <stdlib.h>
+
+#define MASC_POS (TEMP_N_POS - 1)
+// distância (em unidades de tempo) coberta por uma posição do nível n
+#define ALCANCE(n) (1L << (TEMP_BITS_POS * (n)))
+// maior distância que cabe na roda; eventos mais distantes são colocados
+//   no último nível como se fossem nessa distância, e recolocados quando
+//   a posição deles chegar
+#define DIST_MAX (ALCANCE(TEMP_N_NIVEIS) - 1)
+
+// nível dos eventos cujo momento já tinha passado quando foram inseridos
+#define NIVEL_VENCIDOS -1
+
+struct temporizador_t {
+  long atual;        // até onde o tempo já avançou
+  // listas de eventos de cada posição de cada nível
+  temp_no_t *pos[TEMP_N_NIVEIS][TEMP_N_POS];
+  int n_nivel[TEMP_N_NIVEIS];
+  // eventos que já deviam ter acontecido, entregues no próximo avanço
+  temp_no_t *vencidos;
+  int n_eventos;
+  // momento do próximo evento, se 'tem_cache'
+  bool tem_cache;
+  long prox_cache;
+};
+
+// o nó guarda em que lista está no campo 'nivel_pos': o nível e a posição,
+//   ou NIVEL_VENCIDOS
+#define NIVEL(no) ((no)->nivel_pos >> TEMP_BITS_POS)
+#define POSICAO(no) ((no)->nivel_pos & MASC_POS)
+
+temporizador_t *temp_cria(long agora)
+{
+  temporizador_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->atual = agora;
+  for (int nivel = 0; nivel < TEMP_N_NIVEIS; nivel++) {
+    for (int p = 0; p < TEMP_N_POS; p++) {
+      self->pos[nivel][p] = NULL;
+    }
+    self->n_nivel[nivel] = 0;
+  }
+  self->vencidos = NULL;
+  self->n_eventos = 0;
+  self->tem_cache = false;
+  return self;
+}
+
+void temp_destroi(temporizador_t *self)
+{
+  free(self);
+}
+
+void temp_no_inicializa(temp_no_t *no)
+{
+  no->momento = 0;
+  no->dado = NULL;
+  no->ativo = false;
+  no->nivel_pos = 0;
+  no->ant = NULL;
+  no->prox = NULL;
+}
+
+// retorna a lista em que o nó está
+static temp_no_t **lista_do_no(temporizador_t *self, temp_no_t *no)
+{
+  if (no->nivel_pos < 0) return &self->vencidos;
+  return &self->pos[NIVEL(no)][POSICAO(no)];
+}
+
+static void insere_na_lista(temp_no_t **lista, temp_no_t *no)
+{
+  no->ant = NULL;
+  no->prox = *lista;
+  if (*lista != NULL) (*lista)->ant = no;
+  *lista = no;
+}
+
+static void remove_da_lista(temp_no_t **lista, temp_no_t *no)
+{
+  if (no->ant != NULL) {
+    no->ant->prox = no->prox;
+  } else {
+    *lista = no->prox;
+  }
+  if (no->prox != NULL) no->prox->ant = no->ant;
+  no->ant = no->prox = NULL;
+}
+
+// coloca o nó na posição correspondente ao seu momento, relativo ao tempo
+//   atual
+static void coloca(temporizador_t *self, temp_no_t *no)
+{
+  long dist = no->momento - self->atual;
+  if (dist <= 0) {
+    no->nivel_pos = NIVEL_VENCIDOS;
+    insere_na_lista(&self->vencidos, no);
+    return;
+  }
+  long momento = no->momento;
+  if (dist > DIST_MAX) momento = self->atual + DIST_MAX;
+  int nivel = 0;
+  while (nivel < TEMP_N_NIVEIS - 1 && dist >= ALCANCE(nivel + 1)) nivel++;
+  int p = (momento >> (TEMP_BITS_POS * nivel)) & MASC_POS;
+  no->nivel_pos = (nivel << TEMP_BITS_POS) | p;
+  insere_na_lista(&self->pos[nivel][p], no);
+  self->n_nivel[nivel]++;
+}
+
+// tira o nó da lista onde ele está
+static void retira(temporizador_t *self, temp_no_t *no)
+{
+  remove_da_lista(lista_do_no(self, no), no);
+  if (no->nivel_pos >= 0) self->n_nivel[NIVEL(no)]--;
+}
+
+void temp_insere(temporizador_t *self, temp_no_t *no, long momento,
+                 void *dado)
+{
+  if (no->ativo) return;
+  no->momento = momento;
+  no->dado = dado;
+  no->ativo = true;
+  coloca(self, no);
+  self->n_eventos++;
+  if (self->tem_cache && momento < self->prox_cache) {
+    self->prox_cache = momento;
+  }
+}
+
+void temp_remove(temporizador_t *self, temp_no_t *no)
+{
+  if (!no->ativo) return;
+  retira(self, no);
+  no->ativo = false;
+  self->n_eventos--;
+  if (self->tem_cache && no->momento == self->prox_cache) {
+    self->tem_cache = false;
+  }
+}
+
+// redistribui os eventos de uma posição de um nível acima do primeiro,
+//   cujo tempo chegou
+static void cascateia(temporizador_t *self, int nivel, int p)
+{
+  temp_no_t *no = self->pos[nivel][p];
+  self->pos[nivel][p] = NULL;
+  while (no != NULL) {
+    temp_no_t *prox = no->prox;
+    self->n_nivel[nivel]--;
+    coloca(self, no);
+    no = prox;
+  }
+}
+
+// acrescenta os nós da lista 'lista' no final da lista de eventos
+//   acontecidos (que começa em *pprim e termina em *pult)
+static void junta_acontecidos(temporizador_t *self, temp_no_t *lista,
+                              temp_no_t **pprim, temp_no_t **pult)
+{
+  while (lista != NULL) {
+    temp_no_t *no = lista;
+    lista = no->prox;
+    if (no->nivel_pos >= 0) self->n_nivel[NIVEL(no)]--;
+    no->ativo = false;
+    no->ant = NULL;
+    no->prox = NULL;
+    if (*pult == NULL) {
+      *pprim = no;
+    } else {
+      (*pult)->prox = no;
+    }
+    *pult = no;
+    self->n_eventos--;
+  }
+}
+
+temp_no_t *temp_avanca(temporizador_t *self, long agora)
+{
+  temp_no_t *prim = NULL, *ult = NULL;
+  junta_acontecidos(self, self->vencidos, &prim, &ult);
+  self->vencidos = NULL;
+  while (self->atual < agora) {
+    // se os níveis de baixo estão vazios, nada acontece até o início da
+    //   próxima posição do primeiro nível que não está vazio
+    int nivel = 0;
+    while (nivel < TEMP_N_NIVEIS && self->n_nivel[nivel] == 0) nivel++;
+    if (nivel == TEMP_N_NIVEIS) {
+      self->atual = agora;
+      break;
+    }
+    long prox = (self->atual & ~(ALCANCE(nivel) - 1)) + ALCANCE(nivel);
+    if (prox > agora) {
+      self->atual = agora;
+      break;
+    }
+    self->atual = prox;
+    // no início de uma posição de um nível, os eventos dela descem
+    for (int n = 1; n < TEMP_N_NIVEIS; n++) {
+      if ((self->atual & (ALCANCE(n) - 1)) != 0) break;
+      cascateia(self, n, (self->atual >> (TEMP_BITS_POS * n)) & MASC_POS);
+    }
+    // os que desceram para agora ficam nos vencidos
+    junta_acontecidos(self, self->vencidos, &prim, &ult);
+    self->vencidos = NULL;
+    // os eventos da posição do primeiro nível acontecem agora
+    int p = self->atual & MASC_POS;
+    junta_acontecidos(self, self->pos[0][p], &prim, &ult);
+    self->pos[0][p] = NULL;
+  }
+  if (prim != NULL) self->tem_cache = false;
+  return prim;
+}
+
+// retorna o menor momento dos eventos da lista
+static long menor_momento(temp_no_t *lista)
+{
+  long menor = lista->momento;
+  for (temp_no_t *no = lista->prox; no != NULL; no = no->prox) {
+    if (no->momento < menor) menor = no->momento;
+  }
+  return menor;
+}
+
+// calcula o momento do próximo evento
+// as posições de um nível cobrem intervalos de tempo em sequência, a
+//   partir da seguinte à do tempo atual, então o próximo evento de cada
+//   nível está na primeira posição não vazia; no último nível podem estar
+//   eventos além do seu alcance, e são vistas todas as posições
+static long calcula_proximo(temporizador_t *self)
+{
+  bool tem = false;
+  long menor = 0;
+  if (self->vencidos != NULL) {
+    tem = true;
+    menor = menor_momento(self->vencidos);
+  }
+  for (int nivel = 0; nivel < TEMP_N_NIVEIS; nivel++) {
+    if (self->n_nivel[nivel] == 0) continue;
+    long base = self->atual >> (TEMP_BITS_POS * nivel);
+    for (int k = 1; k <= TEMP_N_POS; k++) {
+      temp_no_t *lista = self->pos[nivel][(base + k) & MASC_POS];
+      if (lista == NULL) continue;
+      long m = menor_momento(lista);
+      if (!tem || m < menor) menor = m;
+      tem = true;
+      if (nivel < TEMP_N_NIVEIS - 1) break;
+    }
+  }
+  return menor;
+}
+
+bool temp_proximo(temporizador_t *self, long *pmomento)
+{
+  if (self->n_eventos == 0) return false;
+  if (!self->tem_cache) {
+    self->prox_cache = calcula_proximo(self);
+    self->tem_cache = true;
+  }
+  *pmomento = self->prox_cache;
+  return true;
+}
+
+int temp_n_eventos(temporizador_t *self)
+{
+  return self->n_eventos;
+}
@@ -0,0 +1,70 @@
+#ifndef TEMPORIZADOR_H
+#define TEMPORIZADOR_H
+
+// temporizadores
+// mantém eventos que devem acontecer em um determinado momento, em uma
+//   roda de temporização hierárquica: cada nível tem TEMP_N_POS posições,
+//   e cada posição do nível n cobre TEMP_N_POS^n unidades de tempo
+// um evento é colocado no nível em que cabe a distância até o seu momento;
+//   quando o tempo chega à posição de um nível acima do primeiro, os
+//   eventos dela são redistribuídos nos níveis de baixo
+// inserir e remover um evento custa O(1), e o avanço do tempo custa O(1)
+//   por unidade de tempo, independente do número de eventos; os trechos
+//   em que os níveis de baixo estão vazios são pulados de uma vez
+// os nós dos eventos são fornecidos por quem usa (em geral, fazem parte de
+//   uma estrutura maior), e não são alocados pelo temporizador
+
+#include <stdbool.h>
+
+#define TEMP_BITS_POS 6
+#define TEMP_N_POS    (1 << TEMP_BITS_POS)
+#define TEMP_N_NIVEIS 4
+
+typedef struct temporizador_t temporizador_t;
+
+// um evento no temporizador
+// os campos são mantidos pelo temporizador, e só devem ser lidos
+typedef struct temp_no_t temp_no_t;
+struct temp_no_t {
+  long momento;      // quando o evento deve acontecer
+  void *dado;        // o que foi informado na inserção
+  bool ativo;        // se o nó está no temporizador
+  int nivel_pos;     // onde o nó está, no temporizador
+  temp_no_t *ant;
+  temp_no_t *prox;
+};
+
+// cria um temporizador, cujo tempo atual é 'agora'
+// retorna NULL em caso de erro
+temporizador_t *temp_cria(long agora);
+
+// destrói o temporizador
+// os nós que estiverem nele não são alterados
+void temp_destroi(temporizador_t *self);
+
+// inicializa um nó, que ainda não está em nenhum temporizador
+void temp_no_inicializa(temp_no_t *no);
+
+// insere o evento 'no' no temporizador, para acontecer em 'momento'
+// se o momento já passou, o evento acontece no próximo avanço
+// o nó não pode estar ativo
+void temp_insere(temporizador_t *self, temp_no_t *no, long momento,
+                 void *dado);
+
+// remove o evento 'no' do temporizador, se estiver ativo
+void temp_remove(temporizador_t *self, temp_no_t *no);
+
+// avança o tempo do temporizador até 'agora'
+// retorna a lista dos eventos cujo momento chegou, encadeados por 'prox'
+//   (NULL se nenhum), na ordem em que aconteceram; os nós retornados não
+//   estão mais ativos
+temp_no_t *temp_avanca(temporizador_t *self, long agora);
+
+// retorna true se tem algum evento no temporizador, e coloca em *pmomento
+//   o momento do próximo
+bool temp_proximo(temporizador_t *self, long *pmomento);
+
+// retorna o número de eventos no temporizador
+int temp_n_eventos(temporizador_t *self);
+
+#endif // TEMPORIZADOR_H